@@ -11,12 +11,24 @@
 #include <sstream>
 #include <fstream>
 #include "sha256.h"
+#include "sha256_xN.h"
 #include <uECC.h>
 #include <memory.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <vector>
+#include "BadgeRecord.h"
+#include "WorkerPool.h"
+#include "RadioIDAllocator.h"
+#include "KeyArchive.h"
+#include "BadgeInfoWriter.h"
+#include "KeyDerivation.h"
+#include "FlashAudit.h"
+#include "enigma.h"
+#include "EnigmaSolver.h"
+#include <iterator>
 
 using namespace std;
 
@@ -72,112 +84,343 @@ bool exists(const std::string& name) {
 
 void usage() {
 	cout
-			<< "BadgeGen -u <make uber init file> -c <create daemon keys> -n <number of badge keys to generate> -w <set in pairs> -p <plug board> -m <message to encrypt/decrypt>"
+			<< "BadgeGen -u <make uber init file> -c <create daemon keys> -n <number of badge keys to generate> -j <worker threads for -n and -d, 0 = all cores> -a <write -n keys to this archive instead of ./keys> -x <radio id to extract from -a archive to stdout> -f <registration output: sql, batch, csv or copy> -s <master seed file, derive -n keys from it> -i <first badge index for -s> -d <audit a directory of flash dumps, keys checked against -a if given> -w <set in pairs> -p <plug board> -m <message to encrypt/decrypt> -k <cipher text to find the -w key for> -b <crib for -k> -g <n-gram counts for -k> -t <keys -k reports> -l <plug board pairs -k hill-climbs> -r <checkpoint file for -k>"
 			<< endl;
 }
 
-const char alpha[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-static const uint32_t NUM_ROTORS = 13;
-const char rotors[NUM_ROTORS][27] = { "DVOARQWTUZJCNFLSPMBHEYIGKX", "GHQZUJFWLVMTKOPIRSDEACXYBN",
-		"AKUOCLVJYIXMQPERBWSNGFZHTD", "BKLOSUDPJIRHZEXCGQMNVYFATW", "LICFJPORWQVHANKEBUDYMGZXTS",
-		"CAWFYLKXSZTGHPINMDREUQBJVO", "PYVREUXHKIWDNQAZTLSMBOJGFC", "LQRHNSTPAFIVJYMDGUOZKECWXB",
-		"JAUMCWHXTIZDYORQNSKBEFGLPV", "VRKNGZQOUXTMDIECJYPFSAWBLH", "LUHMZRVEGYSPJFADQCWTKBNXIO",
-		"SDIJUOBALVMYRNGWKHPQCXTFZE", "LIVPNYCUGSRFBXKQHMOEWZTDAJ" };
+std::string radioIDFileName(const uint8_t RadioID[2]) {
+	ostringstream oss;
+	oss << setfill('0') << setw(2) << hex << (int) RadioID[0] << (int) RadioID[1];
+	return oss.str();
+}
 
-long mod26(long a) {
-	return (a % 26 + 26) % 26;
+//sha256(private key + radio id)
+void computeRegCode(BadgeRecord &r) {
+	ShaOBJ shaCtx;
+	sha256_init(&shaCtx);
+	sha256_add(&shaCtx, &r.PrivateKey[0], sizeof(r.PrivateKey));
+	sha256_add(&shaCtx, &r.RadioID[0], sizeof(r.RadioID));
+	sha256_digest(&shaCtx, r.RegCode);
 }
 
-int li(char l) {
-	// Letter index
-	return l - 'A';
+struct GenerateContext {
+	BadgeRecord *Records;
+	uint32_t NumRecords;
+};
+
+//runs on the worker threads: key pairs and registration codes for one chunk of uECC_BATCH_SIZE badges,
+//radio ids are already assigned. The chunk shares a single modular inversion in uECC_make_keys_batch.
+void generateBadgeWork(uint32_t index, uint32_t, void *ctx) {
+	GenerateContext *gc = (GenerateContext *) ctx;
+	uint32_t first = index * uECC_BATCH_SIZE;
+	uint32_t count = gc->NumRecords - first < uECC_BATCH_SIZE ? gc->NumRecords - first : uECC_BATCH_SIZE;
+	uint8_t privKeys[uECC_BATCH_SIZE * BadgeRecord::PRIVATE_KEY_LENGTH];
+	uint8_t pubKeys[uECC_BATCH_SIZE * BadgeRecord::PUBLIC_KEY_LENGTH];
+	bool valid = false;
+	for (int tries = 0; tries < 3 && !valid; tries++) {
+		valid = uECC_make_keys_batch(count, pubKeys, privKeys, theCurve) == 1;
+	}
+	//registration codes for the whole chunk go through the multi-buffer sha256 together
+	uint8_t regInput[uECC_BATCH_SIZE][BadgeRecord::PRIVATE_KEY_LENGTH + 2];
+	const uint8_t *regMsgs[uECC_BATCH_SIZE];
+	uint32 regLens[uECC_BATCH_SIZE];
+	uint8_t regCodes[uECC_BATCH_SIZE][SHA256_XN_DIGEST_SIZE];
+	for (uint32_t i = 0; i < count; i++) {
+		BadgeRecord &r = gc->Records[first + i];
+		memset(&r.CompressedPublicKey[0], 0, sizeof(r.CompressedPublicKey));
+		r.Valid = valid;
+		if (r.Valid) {
+			memcpy(&r.PrivateKey[0], &privKeys[i * BadgeRecord::PRIVATE_KEY_LENGTH], BadgeRecord::PRIVATE_KEY_LENGTH);
+			uECC_compress(&pubKeys[i * BadgeRecord::PUBLIC_KEY_LENGTH], r.CompressedPublicKey, theCurve);
+			//sha256(private key + radio id), same as computeRegCode
+			memcpy(&regInput[i][0], &r.PrivateKey[0], sizeof(r.PrivateKey));
+			memcpy(&regInput[i][sizeof(r.PrivateKey)], &r.RadioID[0], sizeof(r.RadioID));
+			regMsgs[i] = &regInput[i][0];
+			regLens[i] = sizeof(regInput[i]);
+		}
+	}
+	if (valid) {
+		sha256_digest_xN(regMsgs, regLens, regCodes, count);
+		for (uint32_t i = 0; i < count; i++) {
+			memcpy(&gc->Records[first + i].RegCode[0], &regCodes[i][0], BadgeRecord::REG_CODE_LENGTH);
+		}
+	}
 }
 
-int indexof(const char* array, int find) {
-	return strchr(array, find) - array;
+struct DeriveContext {
+	const SeedKeyDeriver *Deriver;
+	uint32_t FirstIndex;
+	BadgeRecord *Records;
+};
+
+//runs on the worker threads: everything about badge FirstIndex+index comes from the seed
+void deriveBadgeWork(uint32_t index, uint32_t, void *ctx) {
+	DeriveContext *dc = (DeriveContext *) ctx;
+	BadgeRecord &r = dc->Records[index];
+	uint8_t unCompressPubKey[BadgeRecord::PUBLIC_KEY_LENGTH];
+	memset(&r.CompressedPublicKey[0], 0, sizeof(r.CompressedPublicKey));
+	r.Valid = dc->Deriver->deriveRadioID(dc->FirstIndex + index, r.RadioID)
+			&& dc->Deriver->derivePrivateKey(dc->FirstIndex + index, r.PrivateKey, unCompressPubKey);
+	if (r.Valid) {
+		uECC_compress(unCompressPubKey, r.CompressedPublicKey, theCurve);
+		computeRegCode(r);
+	}
 }
 
-void doPlug(char *r, const char *swapChars, int s) {
-	for (int l = 0; l < s; l += 2) {
-		int first = strchr(r, swapChars[l]) - r;
-		int second = strchr(r, swapChars[l + 1]) - r;
-		char tmp = r[first];
-		r[first] = r[second];
-		r[second] = tmp;
+//runs on the worker threads: one key file per badge, ids are already unique
+void writeKeyFileWork(uint32_t index, uint32_t, void *ctx) {
+	const BadgeRecord &r = ((const BadgeRecord *) ctx)[index];
+	if (!r.Valid) {
+		return;
 	}
+	std::string fullFileName = "./keys/" + radioIDFileName(r.RadioID);
+	ofstream of(fullFileName.c_str());
+	uint8_t myInfo[BadgeRecord::MY_INFO_SIZE];
+	r.getMyInfo(myInfo);
+	of.write((const char *) &myInfo[0], sizeof(myInfo));
+	of.flush();
 }
 
-char EncryptResult[200];
-
-const char* crypt(char *Wheels, const char *plugBoard, int plugBoardSize, const char *ct) {
-	static const char reflector[] = "YRUHQSLDPXNGOKMIEBFZCWVJAT";
-	// Sets initial permutation
-	int L = li(toupper(Wheels[1]));
-	int M = li(toupper(Wheels[3]));
-	int R = li(toupper(Wheels[5]));
-
-	memset(&EncryptResult[0], 0, sizeof(EncryptResult));
-	char *outPtr = &EncryptResult[0];
-
-	int rotorIdx0 = li(toupper(Wheels[0])) % NUM_ROTORS;
-	int rotorIdx1 = li(toupper(Wheels[2])) % NUM_ROTORS;
-	int rotorIdx2 = li(toupper(Wheels[4])) % NUM_ROTORS;
-
-	char r0[27] = { '\0' };
-	strcpy(&r0[0], rotors[rotorIdx0]);
-	doPlug(&r0[0], plugBoard, plugBoardSize);
-	char r1[27] = { '\0' };
-	strcpy(&r1[0], rotors[rotorIdx1]);
-	doPlug(&r1[0], plugBoard, plugBoardSize);
-	char r2[27] = { '\0' };
-	strcpy(&r2[0], rotors[rotorIdx2]);
-	doPlug(&r2[0], plugBoard, plugBoardSize);
-
-	for (uint16_t x = 0; x < strlen(ct) && x < sizeof(EncryptResult); x++) {
-		if (isspace(ct[x]))
-			continue;
+struct GenerateOptions {
+	int NumberToGen;
+	uint16_t Flags;
+	//merge into this archive instead of writing ./keys
+	const char *ArchiveFile;
+	BadgeInfoWriter::FORMAT SqlFormat;
+	//seed mode: badges FirstIndex..FirstIndex+NumberToGen-1 are derived from Seed instead of the rng
+	const SeedKeyDeriver *Seed;
+	uint32_t FirstIndex;
+};
+
+//the MyInfo block already stored for id, from the archive or ./keys
+bool readStoredMyInfo(const KeyArchive &archive, uint16_t id, uint8_t myInfo[BadgeRecord::MY_INFO_SIZE]) {
+	if (archive.isOpen()) {
+		const uint8_t *block = archive.find(id);
+		if (block) {
+			memcpy(myInfo, block, BadgeRecord::MY_INFO_SIZE);
+			return true;
+		}
+	}
+	uint8_t radioID[2] = { (uint8_t) (id & 0xFF), (uint8_t) (id >> 8) };
+	std::string fileName = "./keys/" + radioIDFileName(radioID);
+	ifstream in(fileName.c_str(), ios::binary);
+	return in.read((char *) myInfo, BadgeRecord::MY_INFO_SIZE).gcount() == BadgeRecord::MY_INFO_SIZE;
+}
 
-		int ct_letter = li(toupper(ct[x]));
+//Generates NumberToGen badges.  Radio ids are handed out up front on this thread from ids not already
+//in ./keys (or the archive), key generation + reg codes and key file writes are spread across the pool
+//and all console/sql output happens on this thread in generation order.
+//In seed mode ids come from the seed instead, an id that is already stored is fine only if it holds
+//exactly what we derived (re-running a range), anything else stops the run before anything is written.
+void generateBadges(const GenerateOptions &opt, WorkerPool &pool) {
+	RadioIDAllocator radioIDs;
+	if (!radioIDs.loadKeyDir("./keys") && !opt.ArchiveFile) {
+		mkdir("./keys", 0700);
+	}
+	KeyArchive archive;
+	if (opt.ArchiveFile) {
+		KeyArchive::ERROR e = archive.open(opt.ArchiveFile);
+		if (e != KeyArchive::NO_ERROR && e != KeyArchive::OPEN_FAILED) {
+			cerr << opt.ArchiveFile << ": " << KeyArchive::errorString(e) << endl;
+			return;
+		}
+		for (uint32_t i = 0; i < archive.getNumRecords(); i++) {
+			radioIDs.markUsed(archive.getRadioID(i));
+		}
+	}
+	if (opt.NumberToGen <= 0) {
+		return;
+	}
+	std::vector<BadgeRecord> batch(opt.NumberToGen);
+	if (opt.Seed) {
+		if (opt.FirstIndex + batch.size() > SeedKeyDeriver::MAX_INDEX) {
+			cerr << "Seed mode indexes must be below " << SeedKeyDeriver::MAX_INDEX << endl;
+			return;
+		}
+		for (uint32_t i = 0; i < batch.size(); i++) {
+			batch[i].Flags = opt.Flags;
+		}
+		DeriveContext dc = { opt.Seed, opt.FirstIndex, &batch[0] };
+		pool.run(batch.size(), deriveBadgeWork, &dc);
+	} else {
+		if (batch.size() > radioIDs.getNumFree()) {
+			cerr << "Only " << radioIDs.getNumFree() << " radio ids left, can't generate " << opt.NumberToGen << endl;
+			return;
+		}
+		for (uint32_t i = 0; i < batch.size(); i++) {
+			radioIDs.allocate(batch[i].RadioID);
+			batch[i].Flags = opt.Flags;
+		}
+		GenerateContext gc = { &batch[0], (uint32_t) batch.size() };
+		pool.run((gc.NumRecords + uECC_BATCH_SIZE - 1) / uECC_BATCH_SIZE, generateBadgeWork, &gc, 1);
+	}
 
-		// Step right rotor on every iteration
-		R = mod26(R + 1);
+	//seed mode: drop badges that are already stored as derived, refuse to clobber anything else
+	std::vector<BadgeRecord> toStore;
+	const std::vector<BadgeRecord> *store = &batch;
+	if (opt.Seed) {
+		for (uint32_t i = 0; i < batch.size(); i++) {
+			const BadgeRecord &r = batch[i];
+			if (r.Valid && radioIDs.isUsed(r.getRadioID())) {
+				uint8_t derived[BadgeRecord::MY_INFO_SIZE], stored[BadgeRecord::MY_INFO_SIZE];
+				r.getMyInfo(derived);
+				if (!readStoredMyInfo(archive, r.getRadioID(), stored) || memcmp(derived, stored, sizeof(derived)) != 0) {
+					cerr << "Radio id " << radioIDFileName(r.RadioID) << " for index " << (opt.FirstIndex + i)
+							<< " is already used by a different key" << endl;
+					return;
+				}
+			} else {
+				toStore.push_back(r);
+			}
+		}
+		store = &toStore;
+	}
+	if (opt.ArchiveFile) {
+		KeyArchive::ERROR e = KeyArchive::write(opt.ArchiveFile, &archive, *store);
+		if (e != KeyArchive::NO_ERROR) {
+			cerr << opt.ArchiveFile << ": " << KeyArchive::errorString(e) << endl;
+			return;
+		}
+	} else if (!store->empty()) {
+		pool.run(store->size(), writeKeyFileWork, (void *) &(*store)[0]);
+	}
 
-		// Pass through rotors
-		char a = r2[mod26(R + ct_letter)];
-		char b = r1[mod26(M + li(a) - R)];
-		char c = r0[mod26(L + li(b) - M)];
+	const char *sqlFileName = BadgeInfoWriter::getDefaultFileName(opt.SqlFormat);
+	BadgeInfoWriter sqlFile(opt.SqlFormat);
+	if (!sqlFile.open(sqlFileName)) {
+		cerr << "Could not open " << sqlFileName << endl;
+	}
+	for (uint32_t i = 0; i < batch.size(); i++) {
+		const BadgeRecord &r = batch[i];
+		if (!r.Valid) {
+			cerr << "Error generating key" << endl;
+			continue;
+		}
+		cout << "RadioID: " << endl;
+		cout << "\t" << setfill('0') << setw(2) << hex << (int) r.RadioID[0] << dec << ":";
+		cout << setfill('0') << setw(2) << hex << (int) r.RadioID[1] << dec << endl;
+		printKeys((uint8_t *) r.PrivateKey, (uint8_t *) r.CompressedPublicKey);
+		cout << endl;
+		cout << endl;
+		sqlFile.addRow(r);
+	}
+	if (!sqlFile.close()) {
+		cerr << "Error writing " << sqlFileName << endl;
+	}
+}
 
-		// Pass through reflector
-		char ref = reflector[mod26(li(c) - L)];
+//master seed for -s, the raw bytes of the file
+bool readSeedFile(const char *fileName, std::vector<uint8_t> &seed) {
+	ifstream in(fileName, ios::binary);
+	if (!in) {
+		return false;
+	}
+	seed.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	//anything shorter than a private key can't carry enough entropy
+	return seed.size() >= BadgeRecord::PRIVATE_KEY_LENGTH;
+}
 
-		// Inverse rotor pass
-		int d = mod26(indexof(&r0[0], alpha[mod26(li(ref) + L)]) - L);
-		int e = mod26(indexof(&r1[0], alpha[mod26(d + M)]) - M);
-		char f = alpha[mod26(indexof(&r2[0], alpha[mod26(e + R)]) - R)];
+//provisioning station side: copy one badge's MyInfo block out of the archive
+int extractFromArchive(const char *archiveFile, const char *radioID) {
+	uint16_t id = 0;
+	if (!RadioIDAllocator::parseKeyFileName(radioID, id)) {
+		cerr << "radio id should look like a ./keys file name, e.g. 10d6" << endl;
+		return -1;
+	}
+	KeyArchive archive;
+	KeyArchive::ERROR e = archive.open(archiveFile);
+	if (e != KeyArchive::NO_ERROR) {
+		cerr << archiveFile << ": " << KeyArchive::errorString(e) << endl;
+		return -1;
+	}
+	const uint8_t *myInfo = archive.find(id);
+	if (!myInfo) {
+		cerr << radioID << " is not in " << archiveFile << endl;
+		return -1;
+	}
+	cout.write((const char *) myInfo, KeyArchive::RECORD_SIZE);
+	cout.flush();
+	return 0;
+}
 
-		*outPtr = f;
-		outPtr++;
+//-d: signatures, duplicates and forged contacts across a directory of badge flash dumps
+int auditDumps(const char *dumpDir, const char *archiveFile, WorkerPool &pool) {
+	KeyArchive archive;
+	if (archiveFile != 0) {
+		KeyArchive::ERROR e = archive.open(archiveFile);
+		if (e != KeyArchive::NO_ERROR) {
+			cerr << archiveFile << ": " << KeyArchive::errorString(e) << endl;
+			return -1;
+		}
 	}
+	FlashAudit audit(archive.isOpen() ? &archive : 0);
+	if (!audit.loadDir(dumpDir)) {
+		cerr << "Could not read " << dumpDir << endl;
+		return -1;
+	}
+	audit.run(pool);
+	FlashAudit::Summary sum = audit.report(cout);
+	return (sum.NumBadBadges + sum.NumInvalid + sum.NumDuplicate + sum.NumForged) == 0 ? 0 : 1;
+}
 
-	return &EncryptResult[0];
+//-k: search every rotor selection and start position for the key that makes ct read best
+int solveEnigma(const char *ct, const char *crib, const char *nGramFile, const char *plugBoard, int climbPairs, int topK,
+		const char *checkpointFile, WorkerPool &pool) {
+	EnigmaSolver solver(ct, topK);
+	if (solver.getNumLetters() == 0) {
+		cerr << "Nothing to solve" << endl;
+		return -1;
+	}
+	if (crib != 0) {
+		solver.setCrib(crib);
+	}
+	if (nGramFile != 0 && !solver.loadNGrams(nGramFile)) {
+		cerr << "Could not read n-grams from " << nGramFile << endl;
+		return -1;
+	}
+	solver.setPlugBoard(plugBoard != 0 ? plugBoard : "");
+	solver.setClimbPairs(climbPairs);
+	if (checkpointFile != 0 && !solver.setCheckpoint(checkpointFile)) {
+		cerr << checkpointFile << " is not a checkpoint of this search, remove it or pick another file" << endl;
+		return -1;
+	}
+	solver.run(pool, cerr);
+	solver.report(cout);
+	return 0;
 }
 
+//the Bench configuration links Bench.cpp's main instead
+#ifndef BADGEGEN_BENCH
 int main(int argc, char *argv[]) {
 	char create = 0, generate = 0, makeUber = 0;
 
 	uint8_t privateKey[24] = { 0x00 };
 	uint8_t unCompressPubKey[48] = { 0x00 };
 	uint8_t compressPubKey[26] = { 0x00 }; //only need 25
-	uint8_t RadioID[2];
-	uint8_t Signature[48];
 	char *wheels = 0;
 	char *msg = 0;
 	char *plugBoard = 0;
 
 	int ch = 0;
 	int numberToGen = 0;
-
-	while ((ch = getopt(argc, argv, "eucn:w:m:p:")) != -1) {
+	int numThreads = 1;
+	char *archiveFile = 0;
+	char *extractID = 0;
+	char *dumpDir = 0;
+	BadgeInfoWriter::FORMAT sqlFormat = BadgeInfoWriter::SQL_INSERT;
+	char *seedFile = 0;
+	int firstIndex = 0;
+	char *solveText = 0;
+	char *crib = 0;
+	char *nGramFile = 0;
+	char *checkpointFile = 0;
+	int topK = 10;
+	int climbPairs = 0;
+
+	//k*G through the fixed-base comb from here on, has to happen before any worker thread starts
+	uECC_precompute_comb(theCurve);
+
+	while ((ch = getopt(argc, argv, "eucn:j:a:x:f:s:i:d:w:m:p:k:b:g:t:l:r:")) != -1) {
 		switch (ch) {
 		case 'c':
 			create = 1;
@@ -186,6 +429,38 @@ int main(int argc, char *argv[]) {
 			numberToGen = atoi(optarg);
 			generate = 1;
 			break;
+		case 'j':
+			numThreads = atoi(optarg);
+			if (numThreads < 0) {
+				usage();
+				return -1;
+			}
+			break;
+		case 'a':
+			archiveFile = optarg;
+			break;
+		case 'x':
+			extractID = optarg;
+			break;
+		case 'f':
+			if (!BadgeInfoWriter::parseFormat(optarg, sqlFormat)) {
+				usage();
+				return -1;
+			}
+			break;
+		case 's':
+			seedFile = optarg;
+			break;
+		case 'i':
+			firstIndex = atoi(optarg);
+			if (firstIndex < 0) {
+				usage();
+				return -1;
+			}
+			break;
+		case 'd':
+			dumpDir = optarg;
+			break;
 		case 'p':
 			plugBoard = optarg;
 			if (strlen(plugBoard) % 2 != 0) {
@@ -206,6 +481,32 @@ int main(int argc, char *argv[]) {
 		case 'm':
 			msg = optarg;
 			break;
+		case 'k':
+			solveText = optarg;
+			break;
+		case 'b':
+			crib = optarg;
+			break;
+		case 'g':
+			nGramFile = optarg;
+			break;
+		case 't':
+			topK = atoi(optarg);
+			if (topK < 1) {
+				usage();
+				return -1;
+			}
+			break;
+		case 'l':
+			climbPairs = atoi(optarg);
+			if (climbPairs < 0) {
+				usage();
+				return -1;
+			}
+			break;
+		case 'r':
+			checkpointFile = optarg;
+			break;
 		case '?':
 		default:
 			usage();
@@ -221,64 +522,47 @@ int main(int argc, char *argv[]) {
 			cerr << "Error generating key" << endl;
 		}
 	} else if (1 == generate) {
-		std::ofstream sqlFile("badge-info.sql");
-		for (int i = 0; i < numberToGen; i++) {
-			if (makeKey(privateKey, unCompressPubKey, compressPubKey)) {
-				uECC_RNG_Function f = uECC_get_rng();
-				f(&RadioID[0], 2);
-				cout << "RadioID: " << endl;
-				cout << "\t" << setfill('0') << setw(2) << hex << (int) RadioID[0] << dec << ":";
-				cout << setfill('0') << setw(2) << hex << (int) RadioID[1] << dec << endl;
-				printKeys(privateKey, compressPubKey);
-				cout << endl;
-				cout << endl;
-				ostringstream oss;
-				oss << setfill('0') << setw(2) << hex << (int) RadioID[0] << (int) RadioID[1] << ends;
-				std::string fileName = oss.str();
-				if (!exists("./keys")) {
-					mkdir("./keys", 0700);
-				}
-				std::string fullFileName = "./keys/" + fileName;
-				if (exists(fullFileName)) {
-					numberToGen++;
-				} else {
-					unsigned short reserveFlags = makeUber == 1 ? 0x1 : 0x0;
-					ofstream of(fullFileName.c_str());
-					//                   			magic 	magic	reserved	Num Contacts 		settings 1		Settings 2
-					const unsigned char magic[2] = { 0xDC, 0xDC };
-					of.write((const char *) &magic[0], sizeof(magic));
-					of.write((const char *) &RadioID[0], sizeof(RadioID));
-					of.write((const char *) &privateKey[0], sizeof(privateKey));
-					of.write((const char *) &reserveFlags, sizeof(reserveFlags));  //just zero-ing out memory
-					of.flush();
-					//generate registration ID
-					ShaOBJ shaCtx;
-					sha256_init(&shaCtx);
-					sha256_add(&shaCtx,&privateKey[0],sizeof(privateKey));
-					sha256_add(&shaCtx,&RadioID[0],sizeof(RadioID));
-					uint8_t digest[32];
-					sha256_digest(&shaCtx,digest);
-					unsigned short rid = (*(unsigned short *)&RadioID[0]);
-					sqlFile << "INSERT INTO BADGE(RADIO_ID, PRIV_KEY, FLAGS, REG_KEY) VALUES (" << rid  << ",'" << std::hex;
-					for(int j=0;j<24;j++) {
-						sqlFile << std::setfill('0') << std::setw(2) << int(privateKey[j]);
-					}
-					sqlFile << "'," <<  std::dec << reserveFlags << ",'"  
-					<< std::hex; 
-					for(unsigned int j=0;j<sizeof(digest);j++) {
-						sqlFile << std::setfill('0') << std::setw(2) << int(digest[j]);
-					}
-					sqlFile << std::dec << "');" << std::endl;
-				}
+		GenerateOptions opt;
+		opt.NumberToGen = numberToGen;
+		opt.Flags = makeUber == 1 ? 0x1 : 0x0;
+		opt.ArchiveFile = archiveFile;
+		opt.SqlFormat = sqlFormat;
+		opt.Seed = 0;
+		opt.FirstIndex = firstIndex;
+		std::vector<uint8_t> seed;
+		if (seedFile != 0) {
+			if (!readSeedFile(seedFile, seed)) {
+				cerr << "Could not read at least " << (int) BadgeRecord::PRIVATE_KEY_LENGTH << " bytes of seed from "
+						<< seedFile << endl;
+				return -1;
 			}
 		}
+		SeedKeyDeriver deriver(seed.empty() ? 0 : &seed[0], seed.size());
+		if (!seed.empty()) {
+			opt.Seed = &deriver;
+		}
+		WorkerPool pool(numThreads);
+		generateBadges(opt, pool);
+	} else if (dumpDir != 0) {
+		WorkerPool pool(numThreads);
+		return auditDumps(dumpDir, archiveFile, pool);
+	} else if (extractID != 0 && archiveFile != 0) {
+		return extractFromArchive(archiveFile, extractID);
+	} else if (solveText != 0) {
+		WorkerPool pool(numThreads);
+		return solveEnigma(solveText, crib, nGramFile, plugBoard, climbPairs, topK, checkpointFile, pool);
 	} else if (wheels != 0) {
-		cout << crypt(wheels, plugBoard, strlen(plugBoard), msg) << endl;
+		Enigma enigma;
+		enigma.setKey(wheels, plugBoard, strlen(plugBoard));
+		char result[200];
+		enigma.crypt(msg, &result[0], sizeof(result));
+		cout << &result[0] << endl;
 	} else {
 		usage();
 	}
 	return 0;
 }
+#endif
 #else
 
 int main() {
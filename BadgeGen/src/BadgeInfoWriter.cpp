@@ -0,0 +1,163 @@
+#include "BadgeInfoWriter.h"
+#include <string.h>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+//longest row we ever append, flush before the buffer can't take another one
+static const uint32_t MAX_ROW_SIZE = 256;
+
+BadgeInfoWriter::BadgeInfoWriter(FORMAT format, uint32_t rowsPerInsert) :
+		Format(format), RowsPerInsert(rowsPerInsert == 0 ? 1 : rowsPerInsert), File(0), Buffer(new char[BUFFER_SIZE]), BufferUsed(
+				0), RowsInStatement(0), Error(false) {
+	if (Format == SQL_INSERT) {
+		RowsPerInsert = 1;
+	}
+}
+
+BadgeInfoWriter::~BadgeInfoWriter() {
+	close();
+	delete[] Buffer;
+}
+
+bool BadgeInfoWriter::parseFormat(const char *name, FORMAT &format) {
+	if (strcmp(name, "sql") == 0) {
+		format = SQL_INSERT;
+	} else if (strcmp(name, "batch") == 0) {
+		format = SQL_BATCH;
+	} else if (strcmp(name, "csv") == 0) {
+		format = CSV;
+	} else if (strcmp(name, "copy") == 0) {
+		format = PG_COPY;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+const char *BadgeInfoWriter::getDefaultFileName(FORMAT format) {
+	return format == CSV ? "badge-info.csv" : "badge-info.sql";
+}
+
+bool BadgeInfoWriter::open(const char *fileName) {
+	close();
+	File = fopen(fileName, "wb");
+	if (!File) {
+		return false;
+	}
+	//we only ever hand stdio big blocks
+	setvbuf(File, 0, _IONBF, 0);
+	Error = false;
+	BufferUsed = 0;
+	RowsInStatement = 0;
+	if (Format == CSV) {
+		append("RADIO_ID,PRIV_KEY,FLAGS,REG_KEY\n");
+	} else if (Format == PG_COPY) {
+		append("COPY BADGE(RADIO_ID, PRIV_KEY, FLAGS, REG_KEY) FROM stdin;\n");
+	}
+	return true;
+}
+
+void BadgeInfoWriter::append(const char *s, uint32_t len) {
+	memcpy(&Buffer[BufferUsed], s, len);
+	BufferUsed += len;
+}
+
+void BadgeInfoWriter::append(const char *s) {
+	append(s, strlen(s));
+}
+
+void BadgeInfoWriter::appendHex(const uint8_t *data, uint32_t len) {
+	char *out = &Buffer[BufferUsed];
+	for (uint32_t i = 0; i < len; i++) {
+		*out++ = HEX_DIGITS[data[i] >> 4];
+		*out++ = HEX_DIGITS[data[i] & 0xF];
+	}
+	BufferUsed += len * 2;
+}
+
+void BadgeInfoWriter::appendUInt(uint32_t v) {
+	char tmp[10];
+	int n = 0;
+	do {
+		tmp[n++] = '0' + (v % 10);
+		v /= 10;
+	} while (v);
+	while (n) {
+		Buffer[BufferUsed++] = tmp[--n];
+	}
+}
+
+void BadgeInfoWriter::flushBuffer() {
+	if (BufferUsed > 0 && File) {
+		if (fwrite(Buffer, 1, BufferUsed, File) != BufferUsed) {
+			Error = true;
+		}
+	}
+	BufferUsed = 0;
+}
+
+void BadgeInfoWriter::addRow(const BadgeRecord &r) {
+	if (!File) {
+		return;
+	}
+	switch (Format) {
+	case SQL_INSERT:
+	case SQL_BATCH:
+		if (RowsInStatement == 0) {
+			append("INSERT INTO BADGE(RADIO_ID, PRIV_KEY, FLAGS, REG_KEY) VALUES (");
+		} else {
+			append(",\n(");
+		}
+		appendUInt(r.getRadioID());
+		append(",'", 2);
+		appendHex(r.PrivateKey, sizeof(r.PrivateKey));
+		append("',", 2);
+		appendUInt(r.Flags);
+		append(",'", 2);
+		appendHex(r.RegCode, sizeof(r.RegCode));
+		append("')", 2);
+		if (++RowsInStatement == RowsPerInsert) {
+			endStatement();
+		}
+		break;
+	case CSV:
+	case PG_COPY: {
+		const char sep = Format == CSV ? ',' : '\t';
+		appendUInt(r.getRadioID());
+		append(&sep, 1);
+		appendHex(r.PrivateKey, sizeof(r.PrivateKey));
+		append(&sep, 1);
+		appendUInt(r.Flags);
+		append(&sep, 1);
+		appendHex(r.RegCode, sizeof(r.RegCode));
+		append("\n", 1);
+	}
+		break;
+	}
+	if (BufferUsed > BUFFER_SIZE - MAX_ROW_SIZE) {
+		flushBuffer();
+	}
+}
+
+void BadgeInfoWriter::endStatement() {
+	if (RowsInStatement > 0) {
+		append(";\n", 2);
+		RowsInStatement = 0;
+	}
+}
+
+bool BadgeInfoWriter::close() {
+	if (!File) {
+		return !Error;
+	}
+	if (Format == SQL_INSERT || Format == SQL_BATCH) {
+		endStatement();
+	} else if (Format == PG_COPY) {
+		append("\\.\n");
+	}
+	flushBuffer();
+	if (fclose(File) != 0) {
+		Error = true;
+	}
+	File = 0;
+	return !Error;
+}
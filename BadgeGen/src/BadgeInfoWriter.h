@@ -0,0 +1,50 @@
+#ifndef BADGE_INFO_WRITER_H
+#define BADGE_INFO_WRITER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "BadgeRecord.h"
+
+//Writes the registration DB rows for generated badges.
+//Rows are hex encoded through a lookup table into one reusable buffer that goes to disk in large
+//blocks, no iostream formatting per byte.
+//	SQL_INSERT	one INSERT per badge (what badge-info.sql always was)
+//	SQL_BATCH	multi row INSERT ... VALUES (...),(...) of up to RowsPerInsert rows
+//	CSV			header + one line per badge for LOAD DATA / \copy ... csv header
+//	PG_COPY		a COPY ... FROM stdin block, can be piped straight into psql
+class BadgeInfoWriter {
+public:
+	enum FORMAT {
+		SQL_INSERT, SQL_BATCH, CSV, PG_COPY
+	};
+	static const uint32_t BUFFER_SIZE = 1 << 20;
+	static const uint32_t DEFAULT_ROWS_PER_INSERT = 1000;
+public:
+	BadgeInfoWriter(FORMAT format, uint32_t rowsPerInsert = DEFAULT_ROWS_PER_INSERT);
+	~BadgeInfoWriter();
+	bool open(const char *fileName);
+	void addRow(const BadgeRecord &r);
+	//closes any open statement and flushes, returns false if anything failed to write
+	bool close();
+	//sql, batch, csv or copy
+	static bool parseFormat(const char *name, FORMAT &format);
+	//default output file for the format
+	static const char *getDefaultFileName(FORMAT format);
+protected:
+	void append(const char *s, uint32_t len);
+	void append(const char *s);
+	void appendHex(const uint8_t *data, uint32_t len);
+	void appendUInt(uint32_t v);
+	void flushBuffer();
+	void endStatement();
+private:
+	FORMAT Format;
+	uint32_t RowsPerInsert;
+	FILE *File;
+	char *Buffer;
+	uint32_t BufferUsed;
+	uint32_t RowsInStatement;
+	bool Error;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef BADGE_RECORD_H
+#define BADGE_RECORD_H
+
+#include <stdint.h>
+#include <string.h>
+
+//everything we generate for a single badge
+//the key file written to ./keys/<radioid> is the MyInfo block the badge reads from 0x800FFD4:
+//		[0-1] 0xdcdc
+//		[2-3] radio id
+//		[4-27] private key
+//		[28-29] flags
+struct BadgeRecord {
+	static const uint8_t PRIVATE_KEY_LENGTH = 24;
+	static const uint8_t PUBLIC_KEY_LENGTH = 48;
+	static const uint8_t PUBLIC_KEY_COMPRESSED_STORAGE_LENGTH = 26;
+	static const uint8_t REG_CODE_LENGTH = 32;
+	static const uint8_t MY_INFO_SIZE = 30;
+
+	uint8_t RadioID[2];
+	uint8_t PrivateKey[PRIVATE_KEY_LENGTH];
+	uint8_t CompressedPublicKey[PUBLIC_KEY_COMPRESSED_STORAGE_LENGTH];
+	//sha256(private key + radio id), what the badge shows as its registration code
+	uint8_t RegCode[REG_CODE_LENGTH];
+	uint16_t Flags;
+	bool Valid;
+
+	uint16_t getRadioID() const {
+		return (uint16_t) (RadioID[0] | (RadioID[1] << 8));
+	}
+	//the 30 bytes that get flashed to the badge
+	void getMyInfo(uint8_t block[MY_INFO_SIZE]) const {
+		block[0] = 0xDC;
+		block[1] = 0xDC;
+		memcpy(&block[2], &RadioID[0], sizeof(RadioID));
+		memcpy(&block[4], &PrivateKey[0], sizeof(PrivateKey));
+		block[28] = Flags & 0xFF;
+		block[29] = Flags >> 8;
+	}
+};
+
+#endif
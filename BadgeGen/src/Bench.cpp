@@ -0,0 +1,654 @@
+//Timing harness for the crypto on the badge pairing path, only built by the Bench configuration
+//(-DBADGEGEN_BENCH, artifact BadgeGen2-bench) which swaps this main in for the one in BadgeGen2.cpp.
+//
+//Every case is warmed up, calibrated so one sample runs for about -t ms, then sampled -r times.
+//ns/op comes from CLOCK_MONOTONIC, cycles/op from the TSC, which ticks at the nominal clock so it
+//reads low when the core turbos and high when it is throttled; compare cycles across runs on one box only.
+#ifdef BADGEGEN_BENCH
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <uECC.h>
+#include "sha256.h"
+#include "sha256_xN.h"
+#include "enigma.h"
+#include "enigma_xN.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+//results land here so the compiler can't drop the calls
+volatile uint32_t Sink = 0;
+
+typedef void (*BenchFunc)(void *ctx, uint32_t iters);
+
+struct BenchCase {
+	std::string Name;
+	BenchFunc Run;
+	void *Ctx;
+	uint32_t Bytes; //message bytes per op for the throughput column, 0 if it doesn't apply
+};
+
+struct BenchResult {
+	std::string Name;
+	uint32_t Bytes;
+	uint32_t Iters;
+	double MedianNs, MinNs, MeanNs, StdDevNs;
+	double MedianCycles, MinCycles;
+};
+
+struct Options {
+	uint32_t Reps;
+	uint32_t SampleMs;
+	uint32_t WarmupMs;
+	const char *Filter;
+	const char *JsonFile;
+};
+
+uint64_t nowNs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+////////////////////////////////////////////////////
+typedef struct SHA256_HashContext {
+	uECC_HashContext uECC;
+	ShaOBJ ctx;
+} SHA256_HashContext;
+
+void init_SHA256(const uECC_HashContext *base) {
+	SHA256_HashContext *context = (SHA256_HashContext *) base;
+	sha256_init(&context->ctx);
+}
+
+void update_SHA256(const uECC_HashContext *base, const uint8_t *message, unsigned message_size) {
+	SHA256_HashContext *context = (SHA256_HashContext *) base;
+	sha256_add(&context->ctx, message, message_size);
+}
+
+void finish_SHA256(const uECC_HashContext *base, uint8_t *hash_result) {
+	SHA256_HashContext *context = (SHA256_HashContext *) base;
+	sha256_digest(&context->ctx, hash_result);
+}
+
+//one badge worth of key material, built once so each case only times its own primitive
+struct EccFixture {
+	uECC_Curve Curve;
+	uint8_t PrivKey[24];
+	uint8_t PubKey[48];
+	uint8_t Compressed[25];
+	uint8_t OtherPubKey[48];
+	uint8_t Hash[32];
+	uint8_t Signature[48];
+};
+
+void benchMakeKey(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	uint8_t privKey[24], pubKey[48];
+	for (uint32_t i = 0; i < iters; i++) {
+		uECC_make_key(pubKey, privKey, f->Curve);
+		Sink += pubKey[0];
+	}
+}
+
+void benchComputePublicKey(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	uint8_t pubKey[48];
+	for (uint32_t i = 0; i < iters; i++) {
+		uECC_compute_public_key(f->PrivKey, pubKey, f->Curve);
+		Sink += pubKey[0];
+	}
+}
+
+void benchSign(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	uint8_t tmp[32 + 32 + 64];
+	SHA256_HashContext hashCtx = { { &init_SHA256, &update_SHA256, &finish_SHA256, 64, 32, &tmp[0] }, ShaOBJ() };
+	uint8_t signature[48];
+	for (uint32_t i = 0; i < iters; i++) {
+		uECC_sign_deterministic(f->PrivKey, f->Hash, sizeof(f->Hash), &hashCtx.uECC, signature, f->Curve);
+		Sink += signature[0];
+	}
+}
+
+void benchVerify(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	for (uint32_t i = 0; i < iters; i++) {
+		Sink += uECC_verify(f->PubKey, f->Hash, sizeof(f->Hash), f->Signature, f->Curve);
+	}
+}
+
+void benchCompress(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	uint8_t compressed[25];
+	for (uint32_t i = 0; i < iters; i++) {
+		uECC_compress(f->PubKey, compressed, f->Curve);
+		Sink += compressed[0];
+	}
+}
+
+void benchDecompress(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	uint8_t pubKey[48];
+	for (uint32_t i = 0; i < iters; i++) {
+		uECC_decompress(f->Compressed, pubKey, f->Curve);
+		Sink += pubKey[47];
+	}
+}
+
+void benchSharedSecret(void *ctx, uint32_t iters) {
+	EccFixture *f = (EccFixture *) ctx;
+	uint8_t secret[24];
+	for (uint32_t i = 0; i < iters; i++) {
+		uECC_shared_secret(f->OtherPubKey, f->PrivKey, secret, f->Curve);
+		Sink += secret[0];
+	}
+}
+
+struct ShaFixture {
+	std::vector<uint8_t> Msg;
+};
+
+void benchSha256(void *ctx, uint32_t iters) {
+	ShaFixture *f = (ShaFixture *) ctx;
+	uint8_t digest[32];
+	for (uint32_t i = 0; i < iters; i++) {
+		ShaOBJ shaCtx;
+		sha256_init(&shaCtx);
+		sha256_add(&shaCtx, &f->Msg[0], f->Msg.size());
+		sha256_digest(&shaCtx, digest);
+		Sink += digest[0];
+	}
+}
+
+//one op is one digest, handed to sha256_digest_xN in groups of XN_GROUP like a BadgeGen chunk
+static const uint32_t XN_GROUP = 64;
+
+struct ShaXNFixture {
+	std::vector<uint8_t> Msgs;
+	uint32_t Len;
+	const uint8_t *Ptrs[XN_GROUP];
+	uint32 Lens[XN_GROUP];
+	uint8_t Digests[XN_GROUP][SHA256_XN_DIGEST_SIZE];
+};
+
+void benchSha256XN(void *ctx, uint32_t iters) {
+	ShaXNFixture *f = (ShaXNFixture *) ctx;
+	for (uint32_t i = 0; i < iters; i += XN_GROUP) {
+		uint32_t n = iters - i < XN_GROUP ? iters - i : XN_GROUP;
+		sha256_digest_xN(f->Ptrs, f->Lens, f->Digests, n);
+		Sink += f->Digests[0][0];
+	}
+}
+
+struct EnigmaFixture {
+	char Wheels[7];
+	const char *PlugBoard;
+	const char *Msg;
+	std::vector<uint8_t> Letters;
+	std::vector<uint8_t> Plain;
+};
+
+//key setup and one message, what the badge does on DECRYPT
+void benchEnigma(void *ctx, uint32_t iters) {
+	EnigmaFixture *f = (EnigmaFixture *) ctx;
+	char out[200];
+	for (uint32_t i = 0; i < iters; i++) {
+		Enigma e;
+		e.setKey(f->Wheels, f->PlugBoard, strlen(f->PlugBoard));
+		e.crypt(f->Msg, &out[0], sizeof(out));
+		Sink += out[0];
+	}
+}
+
+//one op is one trial decrypt, a key setup per 26 of them like a search over right rotor starts
+void benchEnigmaX26(void *ctx, uint32_t iters) {
+	EnigmaFixture *f = (EnigmaFixture *) ctx;
+	for (uint32_t i = 0; i < iters; i += ENIGMA_XN_LANES) {
+		Enigma e;
+		e.setKey(f->Wheels, f->PlugBoard, strlen(f->PlugBoard));
+		enigma_crypt_x26(e, &f->Letters[0], f->Letters.size(), &f->Plain[0]);
+		Sink += f->Plain[0];
+	}
+}
+
+long refMod26(long a) {
+	return (a % 26 + 26) % 26;
+}
+
+int refIndexof(const char *r, int c) {
+	return strchr(r, c) - r;
+}
+
+//the per letter machine BadgeGen and the badge shipped with, kept to check the tables against
+std::string referenceCrypt(const char *wheels, const char *plugBoard, int plugBoardSize, const char *ct) {
+	static const char alpha[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	static const char rotors[Enigma::NUM_ROTORS][27] = { "DVOARQWTUZJCNFLSPMBHEYIGKX", "GHQZUJFWLVMTKOPIRSDEACXYBN",
+			"AKUOCLVJYIXMQPERBWSNGFZHTD", "BKLOSUDPJIRHZEXCGQMNVYFATW", "LICFJPORWQVHANKEBUDYMGZXTS",
+			"CAWFYLKXSZTGHPINMDREUQBJVO", "PYVREUXHKIWDNQAZTLSMBOJGFC", "LQRHNSTPAFIVJYMDGUOZKECWXB",
+			"JAUMCWHXTIZDYORQNSKBEFGLPV", "VRKNGZQOUXTMDIECJYPFSAWBLH", "LUHMZRVEGYSPJFADQCWTKBNXIO",
+			"SDIJUOBALVMYRNGWKHPQCXTFZE", "LIVPNYCUGSRFBXKQHMOEWZTDAJ" };
+	static const char reflector[] = "YRUHQSLDPXNGOKMIEBFZCWVJAT";
+	int L = toupper(wheels[1]) - 'A', M = toupper(wheels[3]) - 'A', R = toupper(wheels[5]) - 'A';
+	char r[3][27];
+	for (int w = 0; w < 3; w++) {
+		strcpy(&r[w][0], rotors[(toupper(wheels[w * 2]) - 'A') % Enigma::NUM_ROTORS]);
+		for (int l = 0; l < plugBoardSize; l += 2) {
+			int first = refIndexof(r[w], plugBoard[l]);
+			int second = refIndexof(r[w], plugBoard[l + 1]);
+			std::swap(r[w][first], r[w][second]);
+		}
+	}
+	std::string out;
+	for (; *ct; ct++) {
+		if (isspace(*ct))
+			continue;
+		int x = toupper(*ct) - 'A';
+		R = refMod26(R + 1);
+		char a = r[2][refMod26(R + x)];
+		char b = r[1][refMod26(M + a - 'A' - R)];
+		char c = r[0][refMod26(L + b - 'A' - M)];
+		char ref = reflector[refMod26(c - 'A' - L)];
+		int d = refMod26(refIndexof(r[0], alpha[refMod26(ref - 'A' + L)]) - L);
+		int e = refMod26(refIndexof(r[1], alpha[refMod26(d + M)]) - M);
+		out += alpha[refMod26(refIndexof(r[2], alpha[refMod26(e + R)]) - R)];
+	}
+	return out;
+}
+
+//random keys through Enigma::crypt and every lane of enigma_crypt_x26 against the reference
+bool checkEnigma() {
+	srand(24);
+	for (uint32_t t = 0; t < 2000; t++) {
+		char wheels[7], plugBoard[13], msg[120], shifted[7];
+		for (int i = 0; i < 6; i++) {
+			wheels[i] = 'A' + rand() % 26;
+		}
+		wheels[6] = '\0';
+		int plugBoardSize = (rand() % 7) * 2;
+		for (int i = 0; i < plugBoardSize; i++) {
+			plugBoard[i] = 'A' + rand() % 26;
+		}
+		plugBoard[plugBoardSize] = '\0';
+		int len = rand() % (sizeof(msg) - 1);
+		for (int i = 0; i < len; i++) {
+			msg[i] = rand() % 8 == 0 ? ' ' : 'A' + rand() % 26;
+		}
+		msg[len] = '\0';
+
+		Enigma e;
+		e.setKey(wheels, plugBoard, plugBoardSize);
+		char out[sizeof(msg)];
+		e.crypt(msg, &out[0], sizeof(out));
+		if (referenceCrypt(wheels, plugBoard, plugBoardSize, msg) != out) {
+			fprintf(stderr, "enigma %s/%s \"%s\": got %s\n", wheels, plugBoard, msg, out);
+			return false;
+		}
+
+		uint8_t letters[sizeof(msg)];
+		uint32_t n = enigma_letters(msg, letters, sizeof(letters));
+		std::vector<uint8_t> plain(n * ENIGMA_XN_LANES);
+		enigma_crypt_x26(e, letters, n, plain.empty() ? 0 : &plain[0]);
+		for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+			memcpy(shifted, wheels, sizeof(shifted));
+			shifted[5] = 'A' + r;
+			std::string ref = referenceCrypt(shifted, plugBoard, plugBoardSize, msg);
+			for (uint32_t i = 0; i < n; i++) {
+				if (plain[i * ENIGMA_XN_LANES + r] != ref[i] - 'A') {
+					fprintf(stderr, "enigma_crypt_x26 %s/%s lane %u letter %u\n", wheels, plugBoard, r, i);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//FIPS 180-2 / NIST CAVS examples, each fed in a few chunkings to cover the partial block handling
+bool checkSha256() {
+	static const struct {
+		const char *Msg;
+		uint32_t Repeat;
+		const char *Digest;
+	} VECTORS[] = {
+		{ "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+		{ "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+		{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+				"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+		{ "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+				1, "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+		{ "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+	};
+	static const uint32_t CHUNKS[] = { 1, 7, 64, 65, 1000 };
+	for (uint32_t v = 0; v < sizeof(VECTORS) / sizeof(VECTORS[0]); v++) {
+		std::string msg;
+		for (uint32_t r = 0; r < VECTORS[v].Repeat; r++) {
+			msg += VECTORS[v].Msg;
+		}
+		for (uint32_t c = 0; c < sizeof(CHUNKS) / sizeof(CHUNKS[0]); c++) {
+			ShaOBJ ctx;
+			sha256_init(&ctx);
+			for (size_t off = 0; off < msg.size(); off += CHUNKS[c]) {
+				sha256_add(&ctx, (const uint8_t *) msg.data() + off, std::min<size_t>(CHUNKS[c], msg.size() - off));
+			}
+			uint8_t digest[32];
+			sha256_digest(&ctx, digest);
+			char hex[65];
+			for (int i = 0; i < 32; i++) {
+				sprintf(&hex[i * 2], "%02x", digest[i]);
+			}
+			if (strcmp(hex, VECTORS[v].Digest) != 0) {
+				fprintf(stderr, "sha256 vector %u, %u byte chunks: got %s\n", v, CHUNKS[c], hex);
+				return false;
+			}
+		}
+		//17 copies puts it in every lane of every SIMD width plus the scalar tail
+		const uint32_t COPIES = 17;
+		const uint8_t *msgs[COPIES];
+		uint32 lens[COPIES];
+		uint8_t digests[COPIES][SHA256_XN_DIGEST_SIZE];
+		for (uint32_t i = 0; i < COPIES; i++) {
+			msgs[i] = (const uint8_t *) msg.data();
+			lens[i] = msg.size();
+		}
+		sha256_digest_xN(msgs, lens, digests, COPIES);
+		for (uint32_t i = 0; i < COPIES; i++) {
+			char hex[65];
+			for (int b = 0; b < 32; b++) {
+				sprintf(&hex[b * 2], "%02x", digests[i][b]);
+			}
+			if (strcmp(hex, VECTORS[v].Digest) != 0) {
+				fprintf(stderr, "sha256_digest_xN (%s) vector %u, copy %u: got %s\n", sha256_xN_impl(), v, i, hex);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////
+
+double timeSample(const BenchCase &bc, uint32_t iters, double &cycles) {
+	uint64_t startCycles = readCycles();
+	uint64_t start = nowNs();
+	bc.Run(bc.Ctx, iters);
+	uint64_t end = nowNs();
+	cycles = (double) (readCycles() - startCycles);
+	return (double) (end - start);
+}
+
+BenchResult runCase(const BenchCase &bc, const Options &opt) {
+	const double sampleNs = opt.SampleMs * 1e6;
+	const uint64_t warmupEnd = nowNs() + (uint64_t) opt.WarmupMs * 1000000ULL;
+	double cycles;
+
+	//grow the batch until one sample is long enough to time, keep going until warm
+	uint32_t iters = 1;
+	double elapsed = timeSample(bc, iters, cycles);
+	while (elapsed < sampleNs / 4 && iters < (1U << 30)) {
+		iters *= 2;
+		elapsed = timeSample(bc, iters, cycles);
+	}
+	while (nowNs() < warmupEnd) {
+		elapsed = timeSample(bc, iters, cycles);
+	}
+	double perOp = elapsed / iters;
+	iters = std::max<uint32_t>(1, (uint32_t) (sampleNs / (perOp > 0 ? perOp : 1)));
+
+	std::vector<double> ns, cyc;
+	for (uint32_t r = 0; r < opt.Reps; r++) {
+		double t = timeSample(bc, iters, cycles);
+		ns.push_back(t / iters);
+		cyc.push_back(cycles / iters);
+	}
+
+	BenchResult res;
+	res.Name = bc.Name;
+	res.Bytes = bc.Bytes;
+	res.Iters = iters;
+	double sum = 0;
+	for (size_t i = 0; i < ns.size(); i++) {
+		sum += ns[i];
+	}
+	res.MeanNs = sum / ns.size();
+	double var = 0;
+	for (size_t i = 0; i < ns.size(); i++) {
+		var += (ns[i] - res.MeanNs) * (ns[i] - res.MeanNs);
+	}
+	res.StdDevNs = ns.size() > 1 ? sqrt(var / (ns.size() - 1)) : 0;
+	std::sort(ns.begin(), ns.end());
+	std::sort(cyc.begin(), cyc.end());
+	size_t mid = ns.size() / 2;
+	res.MedianNs = ns.size() & 1 ? ns[mid] : (ns[mid - 1] + ns[mid]) / 2;
+	res.MedianCycles = cyc.size() & 1 ? cyc[mid] : (cyc[mid - 1] + cyc[mid]) / 2;
+	res.MinNs = ns[0];
+	res.MinCycles = cyc[0];
+	return res;
+}
+
+void printTable(FILE *out, const std::vector<BenchResult> &results) {
+	fprintf(out, "%-26s %12s %12s %10s %14s %12s %10s\n", "case", "median ns", "min ns", "stddev %", "ops/sec",
+			"cycles/op", "MB/s");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult &r = results[i];
+		fprintf(out, "%-26s %12.1f %12.1f %10.2f %14.0f %12.0f", r.Name.c_str(), r.MedianNs, r.MinNs,
+				r.MeanNs > 0 ? 100.0 * r.StdDevNs / r.MeanNs : 0, 1e9 / r.MedianNs, r.MedianCycles);
+		if (r.Bytes) {
+			fprintf(out, " %10.1f\n", r.Bytes * 1e3 / r.MedianNs);
+		} else {
+			fprintf(out, " %10s\n", "-");
+		}
+	}
+}
+
+std::string jsonString(const char *s) {
+	std::string out = "\"";
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') {
+			out += '\\';
+			out += *s;
+		} else if ((unsigned char) *s >= 0x20) {
+			out += *s;
+		}
+	}
+	return out + "\"";
+}
+
+//one object per run, the schema only ever grows so old files stay comparable
+void writeJson(FILE *out, const Options &opt, const std::vector<BenchResult> &results) {
+	char host[256] = "unknown";
+	gethostname(host, sizeof(host) - 1);
+	host[sizeof(host) - 1] = '\0';
+	fprintf(out, "{\n");
+	fprintf(out, "  \"schema\": 1,\n");
+	fprintf(out, "  \"timestamp\": %lu,\n", (unsigned long) time(0));
+	fprintf(out, "  \"host\": %s,\n", jsonString(host).c_str());
+#ifdef __VERSION__
+	fprintf(out, "  \"compiler\": %s,\n", jsonString(__VERSION__).c_str());
+#endif
+	fprintf(out, "  \"curve\": \"secp192r1\",\n");
+	fprintf(out, "  \"sha256_xN\": \"%s\",\n", sha256_xN_impl());
+	fprintf(out, "  \"reps\": %u,\n", opt.Reps);
+	fprintf(out, "  \"sample_ms\": %u,\n", opt.SampleMs);
+	fprintf(out, "  \"warmup_ms\": %u,\n", opt.WarmupMs);
+	fprintf(out, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult &r = results[i];
+		fprintf(out, "    {\"name\": %s, \"bytes\": %u, \"iters_per_sample\": %u, "
+				"\"ns_per_op\": {\"median\": %.2f, \"min\": %.2f, \"mean\": %.2f, \"stddev\": %.2f}, "
+				"\"ops_per_sec\": %.1f, \"cycles_per_op\": {\"median\": %.1f, \"min\": %.1f}",
+				jsonString(r.Name.c_str()).c_str(), r.Bytes, r.Iters, r.MedianNs, r.MinNs, r.MeanNs, r.StdDevNs,
+				1e9 / r.MedianNs, r.MedianCycles, r.MinCycles);
+		if (r.Bytes) {
+			fprintf(out, ", \"mb_per_sec\": %.2f", r.Bytes * 1e3 / r.MedianNs);
+		}
+		fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(out, "  ]\n}\n");
+}
+
+void usage() {
+	fprintf(stderr, "BadgeGen2-bench -r <samples per case, default 11> -t <ms per sample, default 20> "
+			"-w <warmup ms per case, default 100> -f <only cases containing this> -j <write JSON here, - for stdout>\n");
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	Options opt = { 11, 20, 100, 0, 0 };
+	int ch;
+	while ((ch = getopt(argc, argv, "r:t:w:f:j:h")) != -1) {
+		switch (ch) {
+		case 'r':
+			opt.Reps = std::max(1, atoi(optarg));
+			break;
+		case 't':
+			opt.SampleMs = std::max(1, atoi(optarg));
+			break;
+		case 'w':
+			opt.WarmupMs = std::max(0, atoi(optarg));
+			break;
+		case 'f':
+			opt.Filter = optarg;
+			break;
+		case 'j':
+			opt.JsonFile = optarg;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	//nothing below is worth timing if the hash is wrong
+	if (!checkSha256() || !checkEnigma()) {
+		return 1;
+	}
+
+	EccFixture ecc;
+	ecc.Curve = uECC_secp192r1();
+#if uECC_SUPPORT_FIXED_BASE_COMB
+	uECC_precompute_comb(ecc.Curve);
+#endif
+	uint8_t otherPriv[24];
+	if (!uECC_make_key(ecc.PubKey, ecc.PrivKey, ecc.Curve) || !uECC_make_key(ecc.OtherPubKey, otherPriv, ecc.Curve)) {
+		fprintf(stderr, "keygen failed\n");
+		return 1;
+	}
+	uECC_compress(ecc.PubKey, ecc.Compressed, ecc.Curve);
+	//same shape as the pairing messages: hash of RadioID || compressed public key
+	ShaOBJ shaCtx;
+	sha256_init(&shaCtx);
+	sha256_add(&shaCtx, (const uint8_t *) "\x12\x34", 2);
+	sha256_add(&shaCtx, ecc.Compressed, sizeof(ecc.Compressed));
+	sha256_digest(&shaCtx, ecc.Hash);
+	uint8_t tmp[32 + 32 + 64];
+	SHA256_HashContext hashCtx = { { &init_SHA256, &update_SHA256, &finish_SHA256, 64, 32, &tmp[0] }, ShaOBJ() };
+	if (!uECC_sign_deterministic(ecc.PrivKey, ecc.Hash, sizeof(ecc.Hash), &hashCtx.uECC, ecc.Signature, ecc.Curve)
+			|| !uECC_verify(ecc.PubKey, ecc.Hash, sizeof(ecc.Hash), ecc.Signature, ecc.Curve)) {
+		fprintf(stderr, "sign/verify self check failed\n");
+		return 1;
+	}
+
+	//26 = privKey || RadioID for the registration code, 27 = RadioID || compressed key for pairing
+	static const uint32_t SHA_SIZES[] = { 16, 26, 27, 64, 256, 1024, 8192 };
+	static const uint32_t NUM_SHA_SIZES = sizeof(SHA_SIZES) / sizeof(SHA_SIZES[0]);
+	ShaFixture sha[NUM_SHA_SIZES];
+
+	EnigmaFixture enigma;
+	strcpy(&enigma.Wheels[0], "ACEGIK");
+	enigma.PlugBoard = "ABCDEF";
+	enigma.Msg = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG";
+	enigma.Letters.resize(strlen(enigma.Msg));
+	enigma.Letters.resize(enigma_letters(enigma.Msg, &enigma.Letters[0], enigma.Letters.size()));
+	enigma.Plain.resize(enigma.Letters.size() * ENIGMA_XN_LANES);
+
+	std::vector<BenchCase> cases;
+	BenchCase eccCases[] = {
+		{ "uECC_make_key", benchMakeKey, &ecc, 0 },
+		{ "uECC_compute_public_key", benchComputePublicKey, &ecc, 0 },
+		{ "uECC_sign_deterministic", benchSign, &ecc, 0 },
+		{ "uECC_verify", benchVerify, &ecc, 0 },
+		{ "uECC_compress", benchCompress, &ecc, 0 },
+		{ "uECC_decompress", benchDecompress, &ecc, 0 },
+		{ "uECC_shared_secret", benchSharedSecret, &ecc, 0 },
+	};
+	cases.insert(cases.end(), &eccCases[0], &eccCases[sizeof(eccCases) / sizeof(eccCases[0])]);
+	for (uint32_t i = 0; i < NUM_SHA_SIZES; i++) {
+		sha[i].Msg.resize(SHA_SIZES[i]);
+		for (uint32_t b = 0; b < SHA_SIZES[i]; b++) {
+			sha[i].Msg[b] = b * 31 + 7;
+		}
+		char name[32];
+		sprintf(&name[0], "sha256/%u", SHA_SIZES[i]);
+		BenchCase bc = { name, benchSha256, &sha[i], SHA_SIZES[i] };
+		cases.push_back(bc);
+	}
+	ShaXNFixture shaXN[NUM_SHA_SIZES];
+	for (uint32_t i = 0; i < NUM_SHA_SIZES && SHA_SIZES[i] <= 256; i++) {
+		shaXN[i].Len = SHA_SIZES[i];
+		shaXN[i].Msgs.resize(XN_GROUP * SHA_SIZES[i] + 1);
+		for (size_t b = 0; b < shaXN[i].Msgs.size(); b++) {
+			shaXN[i].Msgs[b] = b * 131 + 3;
+		}
+		for (uint32_t m = 0; m < XN_GROUP; m++) {
+			shaXN[i].Ptrs[m] = &shaXN[i].Msgs[m * SHA_SIZES[i]];
+			shaXN[i].Lens[m] = SHA_SIZES[i];
+		}
+		char name[32];
+		sprintf(&name[0], "sha256_xN/%u", SHA_SIZES[i]);
+		BenchCase bc = { name, benchSha256XN, &shaXN[i], SHA_SIZES[i] };
+		cases.push_back(bc);
+	}
+	BenchCase enigmaCases[] = {
+		{ "enigma_crypt", benchEnigma, &enigma, 0 },
+		{ "enigma_crypt_x26", benchEnigmaX26, &enigma, 0 },
+	};
+	cases.insert(cases.end(), &enigmaCases[0], &enigmaCases[sizeof(enigmaCases) / sizeof(enigmaCases[0])]);
+
+	//the table goes to stderr when stdout is carrying the JSON
+	bool jsonToStdout = opt.JsonFile != 0 && strcmp(opt.JsonFile, "-") == 0;
+	FILE *table = jsonToStdout ? stderr : stdout;
+	std::vector<BenchResult> results;
+	for (size_t i = 0; i < cases.size(); i++) {
+		if (opt.Filter != 0 && cases[i].Name.find(opt.Filter) == std::string::npos) {
+			continue;
+		}
+		results.push_back(runCase(cases[i], opt));
+	}
+	printTable(table, results);
+
+	if (opt.JsonFile != 0) {
+		FILE *out = jsonToStdout ? stdout : fopen(opt.JsonFile, "w");
+		if (out == 0) {
+			fprintf(stderr, "can't open %s\n", opt.JsonFile);
+			return 1;
+		}
+		writeJson(out, opt, results);
+		if (out != stdout) {
+			fclose(out);
+		}
+	}
+	return 0;
+}
+
+#endif
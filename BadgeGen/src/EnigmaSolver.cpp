@@ -0,0 +1,419 @@
+#include "EnigmaSolver.h"
+#include "sha256.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const uint32_t N = Enigma::NUM_LETTERS;
+static const uint32_t NUM_ROTORS = Enigma::NUM_ROTORS;
+static const uint32_t MAX_CLIMB_PASSES = 32;
+
+//English letter frequencies in percent, the scoring when there is no -g file
+static const double ENGLISH[N] = { 8.17, 1.29, 2.78, 4.25, 12.70, 2.23, 2.02, 6.09, 6.97, 0.15, 0.77, 4.03, 2.41, 6.75,
+		7.51, 1.93, 0.10, 5.99, 6.33, 9.06, 2.76, 0.98, 2.36, 0.15, 1.97, 0.07 };
+
+static double now() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void taskWheels(uint32_t task, char wheels[7]) {
+	uint32_t rotors = task / (N * N);
+	wheels[0] = 'A' + rotors / (NUM_ROTORS * NUM_ROTORS);
+	wheels[1] = 'A' + (task / N) % N;
+	wheels[2] = 'A' + (rotors / NUM_ROTORS) % NUM_ROTORS;
+	wheels[3] = 'A' + task % N;
+	wheels[4] = 'A' + rotors % NUM_ROTORS;
+	wheels[5] = 'A';
+	wheels[6] = '\0';
+}
+
+bool EnigmaSolver::better(const Score &a, const Score &b) {
+	return a.Crib != b.Crib ? a.Crib > b.Crib : a.NGram > b.NGram;
+}
+
+static bool candidateBetter(const EnigmaSolver::Candidate &a, const EnigmaSolver::Candidate &b) {
+	return EnigmaSolver::better(a.S, b.S);
+}
+
+static bool sameKey(const EnigmaSolver::Candidate &a, const EnigmaSolver::Candidate &b) {
+	return strcmp(a.Wheels, b.Wheels) == 0 && strcmp(a.PlugBoard, b.PlugBoard) == 0;
+}
+
+EnigmaSolver::EnigmaSolver(const char *ct, uint32_t topK) :
+		CipherText(ct), Letters(), TopK(topK == 0 ? 1 : topK), Crib(), CribOffsets(), NGramFile(), NGramN(1), NGrams(N),
+		PlugBoard(), ClimbPairs(0), CheckpointFile(), NextTask(0), KeysTried(0), Seconds(0), Best(), SliceStart(0),
+		Workers() {
+	Letters.resize(CipherText.size());
+	Letters.resize(enigma_letters(ct, Letters.empty() ? 0 : &Letters[0], Letters.size()));
+	for (uint32_t i = 0; i < N; i++) {
+		NGrams[i] = log10(ENGLISH[i] / 100.0);
+	}
+}
+
+void EnigmaSolver::setCrib(const char *crib) {
+	Crib.resize(strlen(crib));
+	Crib.resize(enigma_letters(crib, Crib.empty() ? 0 : &Crib[0], Crib.size()));
+	CribOffsets.clear();
+	for (uint32_t o = 0; Crib.size() > 0 && o + Crib.size() <= Letters.size(); o++) {
+		bool possible = true;
+		for (uint32_t j = 0; j < Crib.size() && possible; j++) {
+			possible = Crib[j] != Letters[o + j];
+		}
+		if (possible) {
+			CribOffsets.push_back(o);
+		}
+	}
+}
+
+bool EnigmaSolver::loadNGrams(const char *fileName) {
+	std::ifstream in(fileName);
+	if (!in) {
+		return false;
+	}
+	std::vector<std::pair<std::string, double> > counts;
+	std::string gram;
+	double count, total = 0;
+	uint32_t n = 0;
+	while (in >> gram >> count) {
+		if (n == 0) {
+			n = gram.size();
+		}
+		if (n > MAX_NGRAM || gram.size() != n || count <= 0) {
+			continue;
+		}
+		counts.push_back(std::make_pair(gram, count));
+		total += count;
+	}
+	if (counts.empty()) {
+		return false;
+	}
+	uint32_t size = 1;
+	for (uint32_t i = 0; i < n; i++) {
+		size *= N;
+	}
+	//unseen n-grams get a hundredth of a single sighting
+	NGrams.assign(size, (float) log10(0.01 / total));
+	for (size_t i = 0; i < counts.size(); i++) {
+		uint32_t idx = 0;
+		for (uint32_t c = 0; c < n; c++) {
+			idx = idx * N + Enigma::letterIndex(counts[i].first[c]);
+		}
+		NGrams[idx] = log10(counts[i].second / total);
+	}
+	NGramN = n;
+	NGramFile = fileName;
+	return true;
+}
+
+void EnigmaSolver::setPlugBoard(const char *plugBoard) {
+	PlugBoard.assign(plugBoard, std::min<size_t>(strlen(plugBoard), MAX_PAIRS * 2) & ~1);
+}
+
+void EnigmaSolver::setClimbPairs(uint32_t pairs) {
+	ClimbPairs = std::min(pairs, MAX_PAIRS);
+}
+
+uint32_t EnigmaSolver::getNumLetters() const {
+	return Letters.size();
+}
+
+const std::vector<EnigmaSolver::Candidate> &EnigmaSolver::getBest() const {
+	return Best;
+}
+
+//plain is lane major (enigma_crypt_x26), every loop runs across the 26 lanes
+void EnigmaSolver::scoreLanes(const uint8_t *plain, Score scores[ENIGMA_XN_LANES]) const {
+	const uint32_t len = Letters.size();
+	uint32_t crib[ENIGMA_XN_LANES] = { 0 };
+	for (size_t o = 0; o < CribOffsets.size(); o++) {
+		uint32_t matched[ENIGMA_XN_LANES] = { 0 };
+		const uint8_t *row = plain + CribOffsets[o] * ENIGMA_XN_LANES;
+		for (uint32_t j = 0; j < Crib.size(); j++, row += ENIGMA_XN_LANES) {
+			for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+				matched[r] += row[r] == Crib[j];
+			}
+		}
+		for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+			crib[r] = std::max(crib[r], matched[r]);
+		}
+	}
+
+	float ngram[ENIGMA_XN_LANES] = { 0 };
+	uint32_t idx[ENIGMA_XN_LANES] = { 0 };
+	const uint32_t size = NGrams.size();
+	for (uint32_t i = 0; i < len; i++) {
+		const uint8_t *row = plain + i * ENIGMA_XN_LANES;
+		for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+			idx[r] = (idx[r] * N + row[r]) % size;
+		}
+		if (i + 1 >= NGramN) {
+			for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+				ngram[r] += NGrams[idx[r]];
+			}
+		}
+	}
+	for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+		scores[r].Crib = crib[r];
+		scores[r].NGram = ngram[r];
+	}
+}
+
+//keeps best sorted and at most TopK long
+void EnigmaSolver::offer(std::vector<Candidate> &best, const Candidate &c) const {
+	if (best.size() >= TopK && !better(c.S, best.back().S)) {
+		return;
+	}
+	for (size_t i = 0; i < best.size(); i++) {
+		if (sameKey(best[i], c)) {
+			return;
+		}
+	}
+	best.insert(std::upper_bound(best.begin(), best.end(), c, candidateBetter), c);
+	if (best.size() > TopK) {
+		best.pop_back();
+	}
+}
+
+void EnigmaSolver::searchWork(uint32_t index, uint32_t worker, void *ctx) {
+	EnigmaSolver *s = (EnigmaSolver *) ctx;
+	WorkerState &ws = s->Workers[worker];
+	Candidate c;
+	taskWheels(s->SliceStart + index, c.Wheels);
+	strcpy(c.PlugBoard, s->PlugBoard.c_str());
+	Enigma e;
+	e.setKey(c.Wheels, c.PlugBoard, s->PlugBoard.size());
+	enigma_crypt_x26(e, &s->Letters[0], s->Letters.size(), &ws.Plain[0]);
+	Score scores[ENIGMA_XN_LANES];
+	s->scoreLanes(&ws.Plain[0], scores);
+	for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+		c.Wheels[5] = 'A' + r;
+		c.S = scores[r];
+		s->offer(ws.Best, c);
+	}
+	ws.Keys += ENIGMA_XN_LANES;
+}
+
+//the plug board's pairs, padded with empty slots up to pairs
+static std::vector<std::string> plugSlots(const char *plugBoard, uint32_t pairs) {
+	std::vector<std::string> slots;
+	for (size_t i = 0; i + 1 < strlen(plugBoard); i += 2) {
+		slots.push_back(std::string(&plugBoard[i], 2));
+	}
+	if (slots.size() < pairs) {
+		slots.resize(pairs);
+	}
+	return slots;
+}
+
+//steepest ascent over one pair at a time: each slot tries all 325 pairs, right rotor start comes along for free
+void EnigmaSolver::climb(Candidate &c, WorkerState &ws) const {
+	std::vector<std::string> slots = plugSlots(c.PlugBoard, ClimbPairs);
+	Score scores[ENIGMA_XN_LANES];
+	for (uint32_t pass = 0; pass < MAX_CLIMB_PASSES; pass++) {
+		Candidate best = c;
+		for (size_t slot = 0; slot < slots.size(); slot++) {
+			std::vector<std::string> trial = slots;
+			for (char a = 'A'; a <= 'Z'; a++) {
+				for (char b = a + 1; b <= 'Z'; b++) {
+					trial[slot] = std::string(1, a) + b;
+					std::string plug;
+					for (size_t i = 0; i < trial.size(); i++) {
+						plug += trial[i];
+					}
+					Enigma e;
+					e.setKey(c.Wheels, plug.c_str(), plug.size());
+					enigma_crypt_x26(e, &Letters[0], Letters.size(), &ws.Plain[0]);
+					scoreLanes(&ws.Plain[0], scores);
+					ws.Keys += ENIGMA_XN_LANES;
+					for (uint32_t r = 0; r < ENIGMA_XN_LANES; r++) {
+						if (better(scores[r], best.S)) {
+							best.S = scores[r];
+							best.Wheels[5] = 'A' + r;
+							strcpy(best.PlugBoard, plug.c_str());
+						}
+					}
+				}
+			}
+		}
+		if (sameKey(best, c)) {
+			break;
+		}
+		c = best;
+		slots = plugSlots(c.PlugBoard, ClimbPairs);
+	}
+}
+
+void EnigmaSolver::climbWork(uint32_t index, uint32_t worker, void *ctx) {
+	EnigmaSolver *s = (EnigmaSolver *) ctx;
+	s->climb(s->Best[index], s->Workers[worker]);
+}
+
+void EnigmaSolver::mergeWorkers() {
+	for (size_t w = 0; w < Workers.size(); w++) {
+		for (size_t i = 0; i < Workers[w].Best.size(); i++) {
+			offer(Best, Workers[w].Best[i]);
+		}
+		Workers[w].Best.clear();
+		KeysTried += Workers[w].Keys;
+		Workers[w].Keys = 0;
+	}
+}
+
+//anything that changes the scores or the search space makes an old checkpoint useless
+std::string EnigmaSolver::settingsHash() const {
+	std::ostringstream settings;
+	settings << "enigma-solve|" << std::string(Letters.begin(), Letters.end()) << "|"
+			<< std::string(Crib.begin(), Crib.end()) << "|" << NGramFile << "|" << PlugBoard << "|" << TopK;
+	std::string s = settings.str();
+	ShaOBJ ctx;
+	uint8_t digest[32];
+	sha256_init(&ctx);
+	sha256_add(&ctx, (const uint8_t *) s.data(), s.size());
+	sha256_digest(&ctx, digest);
+	char hex[65];
+	for (int i = 0; i < 32; i++) {
+		sprintf(&hex[i * 2], "%02x", digest[i]);
+	}
+	return std::string(&hex[0]);
+}
+
+//text, written to fileName.tmp and renamed so a kill mid write leaves the last one intact
+void EnigmaSolver::writeCheckpoint() const {
+	if (CheckpointFile.empty()) {
+		return;
+	}
+	std::string tmpName = CheckpointFile + ".tmp";
+	FILE *f = fopen(tmpName.c_str(), "w");
+	if (f == 0) {
+		return;
+	}
+	fprintf(f, "enigma-solve 1\nsettings %s\nnext %u\nkeys %llu\nseconds %.3f\n", settingsHash().c_str(), NextTask,
+			(unsigned long long) KeysTried, Seconds);
+	for (size_t i = 0; i < Best.size(); i++) {
+		fprintf(f, "key %s %s %u %.9g\n", Best[i].Wheels, Best[i].PlugBoard[0] ? Best[i].PlugBoard : "-",
+				Best[i].S.Crib, Best[i].S.NGram);
+	}
+	bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+	ok = fclose(f) == 0 && ok;
+	if (!ok || rename(tmpName.c_str(), CheckpointFile.c_str()) != 0) {
+		unlink(tmpName.c_str());
+	}
+}
+
+bool EnigmaSolver::readCheckpoint() {
+	std::ifstream in(CheckpointFile.c_str());
+	std::string tag, settings;
+	int version = 0;
+	uint32_t next = 0;
+	unsigned long long keys = 0;
+	double seconds = 0;
+	if (!(in >> tag >> version) || tag != "enigma-solve" || version != 1 || !(in >> tag >> settings)
+			|| settings != settingsHash() || !(in >> tag >> next >> tag >> keys >> tag >> seconds) || next > NUM_TASKS) {
+		return false;
+	}
+	std::vector<Candidate> best;
+	std::string wheels, plug;
+	Candidate c;
+	while (in >> tag >> wheels >> plug >> c.S.Crib >> c.S.NGram && tag == "key") {
+		if (wheels.size() != 6 || plug.size() > MAX_PAIRS * 2) {
+			return false;
+		}
+		strcpy(c.Wheels, wheels.c_str());
+		strcpy(c.PlugBoard, plug == "-" ? "" : plug.c_str());
+		best.push_back(c);
+	}
+	NextTask = next;
+	KeysTried = keys;
+	Seconds = seconds;
+	Best = best;
+	return true;
+}
+
+bool EnigmaSolver::setCheckpoint(const char *fileName) {
+	CheckpointFile = fileName;
+	if (access(fileName, F_OK) != 0) {
+		return true;
+	}
+	return readCheckpoint();
+}
+
+void EnigmaSolver::run(WorkerPool &pool, std::ostream &log) {
+	Workers.resize(pool.getNumThreads());
+	for (size_t w = 0; w < Workers.size(); w++) {
+		Workers[w].Plain.resize(std::max<size_t>(Letters.size(), 1) * ENIGMA_XN_LANES);
+		Workers[w].Keys = 0;
+	}
+	if (Letters.empty()) {
+		return;
+	}
+	if (NextTask > 0) {
+		log << "resuming at task " << NextTask << " of " << NUM_TASKS << ", " << KeysTried << " keys already tried"
+				<< std::endl;
+	}
+
+	//log is usually cerr, put its formatting back when done
+	const std::ios::fmtflags flags = log.flags();
+	const std::streamsize precision = log.precision();
+	double start = now(), lastCheckpoint = start;
+	const double previous = Seconds;
+	const uint64_t previousKeys = KeysTried;
+	while (NextTask < NUM_TASKS) {
+		SliceStart = NextTask;
+		uint32_t count = std::min(SLICE_SIZE, NUM_TASKS - NextTask);
+		pool.run(count, searchWork, this, 1);
+		mergeWorkers();
+		NextTask += count;
+		double t = now();
+		Seconds = previous + (t - start);
+		if (t - lastCheckpoint >= CHECKPOINT_SECONDS || NextTask == NUM_TASKS) {
+			writeCheckpoint();
+			lastCheckpoint = t;
+			log << std::fixed << std::setprecision(1) << (100.0 * NextTask / NUM_TASKS) << "% " << KeysTried << " keys, "
+					<< (uint64_t) ((KeysTried - previousKeys) / std::max(t - start, 1e-9)) << " keys/sec" << std::endl;
+		}
+	}
+	log << "search: " << KeysTried << " keys in " << std::fixed << std::setprecision(1) << Seconds << "s, "
+			<< (uint64_t) (KeysTried / std::max(Seconds, 1e-9)) << " keys/sec on " << pool.getNumThreads()
+			<< " threads" << std::endl;
+
+	if (ClimbPairs > 0 && !Best.empty()) {
+		uint64_t before = KeysTried;
+		double climbStart = now();
+		pool.run(Best.size(), climbWork, this, 1);
+		//climbs that met on the same key collapse into one
+		std::vector<Candidate> climbed = Best;
+		Best.clear();
+		for (size_t i = 0; i < climbed.size(); i++) {
+			offer(Best, climbed[i]);
+		}
+		mergeWorkers();
+		double t = now() - climbStart;
+		log << "plug board climb: " << (KeysTried - before) << " keys in " << std::fixed << std::setprecision(1) << t << "s, "
+				<< (uint64_t) ((KeysTried - before) / std::max(t, 1e-9)) << " keys/sec" << std::endl;
+	}
+	log.flags(flags);
+	log.precision(precision);
+}
+
+void EnigmaSolver::report(std::ostream &out) const {
+	for (size_t i = 0; i < Best.size(); i++) {
+		const Candidate &c = Best[i];
+		Enigma e;
+		e.setKey(c.Wheels, c.PlugBoard, strlen(c.PlugBoard));
+		std::vector<char> plain(Letters.size() + 1);
+		e.crypt(CipherText.c_str(), &plain[0], plain.size());
+		out << (i + 1) << ": -w " << c.Wheels << " -p " << (c.PlugBoard[0] ? c.PlugBoard : "\"\"");
+		if (!Crib.empty()) {
+			out << " crib " << c.S.Crib << "/" << Crib.size();
+		}
+		out << " score " << std::fixed << std::setprecision(2) << c.S.NGram << " " << &plain[0] << std::endl;
+	}
+}
@@ -0,0 +1,96 @@
+#ifndef ENIGMA_SOLVER_H
+#define ENIGMA_SOLVER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "enigma_xN.h"
+#include "WorkerPool.h"
+
+//Ciphertext only key search for the badge Enigma (-k).
+//Every rotor selection and left/middle position is one task, enigma_crypt_x26 tries all 26 right rotor starts
+//of it at once: 13^3 * 26^2 tasks, 13^3 * 26^3 keys. Tasks are handed to the pool in slices, after each slice the
+//per worker top lists are merged and, every CHECKPOINT_SECONDS, written to the checkpoint file so a killed search
+//picks up at the next slice. The best keys then get their plug board hill-climbed one pair at a time.
+//
+//A candidate is scored by its crib first, if there is one (most crib letters matched at any offset the crib can
+//sit at, this Enigma never maps a letter to itself), then by n-gram log probability: from -g, a file of
+//"NGRAM count" lines (n up to 4, the usual quadgram lists work), or English letter frequencies without it.
+class EnigmaSolver {
+public:
+	static const uint32_t NUM_TASKS = Enigma::NUM_ROTORS * Enigma::NUM_ROTORS * Enigma::NUM_ROTORS
+			* Enigma::NUM_LETTERS * Enigma::NUM_LETTERS;
+	static const uint32_t SLICE_SIZE = 8192;
+	static const uint32_t CHECKPOINT_SECONDS = 30;
+	static const uint32_t MAX_NGRAM = 4;
+	//every letter paired
+	static const uint32_t MAX_PAIRS = Enigma::NUM_LETTERS / 2;
+
+	struct Score {
+		uint32_t Crib;
+		float NGram;
+	};
+	struct Candidate {
+		char Wheels[7];
+		char PlugBoard[MAX_PAIRS * 2 + 1];
+		Score S;
+	};
+public:
+	//ct is the ciphertext as typed, whitespace is dropped
+	EnigmaSolver(const char *ct, uint32_t topK);
+	void setCrib(const char *crib);
+	//returns false if the file can't be read or has no usable n-grams
+	bool loadNGrams(const char *fileName);
+	//fixed for the search and the starting point of the climb
+	void setPlugBoard(const char *plugBoard);
+	//plug board pairs to hill-climb, 0 for none
+	void setClimbPairs(uint32_t pairs);
+	//resumes from fileName if it holds a checkpoint of this same search, returns false if it is for another one
+	bool setCheckpoint(const char *fileName);
+	uint32_t getNumLetters() const;
+	//progress and throughput go to log
+	void run(WorkerPool &pool, std::ostream &log);
+	//best first, with the decrypt of each
+	void report(std::ostream &out) const;
+	const std::vector<Candidate> &getBest() const;
+	static bool better(const Score &a, const Score &b);
+private:
+	struct WorkerState {
+		std::vector<uint8_t> Plain;
+		std::vector<Candidate> Best;
+		uint64_t Keys;
+	};
+	void scoreLanes(const uint8_t *plain, Score scores[ENIGMA_XN_LANES]) const;
+	void offer(std::vector<Candidate> &best, const Candidate &c) const;
+	void mergeWorkers();
+	void writeCheckpoint() const;
+	bool readCheckpoint();
+	std::string settingsHash() const;
+	void climb(Candidate &c, WorkerState &ws) const;
+	static void searchWork(uint32_t index, uint32_t worker, void *ctx);
+	static void climbWork(uint32_t index, uint32_t worker, void *ctx);
+private:
+	std::string CipherText;
+	std::vector<uint8_t> Letters;
+	uint32_t TopK;
+	std::vector<uint8_t> Crib;
+	//offsets where no crib letter sits on the same ciphertext letter
+	std::vector<uint32_t> CribOffsets;
+	std::string NGramFile;
+	uint32_t NGramN;
+	std::vector<float> NGrams;
+	std::string PlugBoard;
+	uint32_t ClimbPairs;
+	std::string CheckpointFile;
+	//search state, what a checkpoint holds
+	uint32_t NextTask;
+	uint64_t KeysTried;
+	double Seconds;
+	std::vector<Candidate> Best;
+	//run state
+	uint32_t SliceStart;
+	std::vector<WorkerState> Workers;
+};
+
+#endif
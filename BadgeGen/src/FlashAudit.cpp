@@ -0,0 +1,456 @@
+#include "FlashAudit.h"
+#include "sha256.h"
+#include <uECC.h>
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const uint32_t MY_INFO_OFFSET = FlashAudit::MY_INFO_ADDRESS - FlashAudit::STORE_ADDRESS;
+//contact problems that mean the stored pairing itself is broken
+static const uint32_t INVALID_PROBLEMS = FlashAudit::BAD_RADIO_ID | FlashAudit::BAD_KEY | FlashAudit::BAD_SIGNATURE;
+static const uint32_t FORGED_PROBLEMS = FlashAudit::FORGED | FlashAudit::KEY_CONFLICT;
+//badge problems that leave us without the owner's key
+static const uint32_t NO_OWNER_PROBLEMS = FlashAudit::UNREADABLE | FlashAudit::NO_MY_INFO | FlashAudit::BAD_PRIVATE_KEY;
+
+static uint16_t readU16(const uint8_t *p) {
+	return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+//same spelling as the ./keys file names so ids can be looked up there
+static std::string radioIDName(uint16_t id) {
+	char buf[8];
+	sprintf(&buf[0], "%02x%x", id & 0xFF, id >> 8);
+	return std::string(&buf[0]);
+}
+
+//erased flash is 0xFF, names are at most 12 chars and may not be terminated
+static void copyName(char *to, const uint8_t *from) {
+	for (uint32_t i = 0; i < FlashAudit::AGENT_NAME_LENGTH; i++) {
+		to[i] = from[i] >= 0x20 && from[i] < 0x7F ? from[i] : (from[i] == 0 ? 0 : '?');
+	}
+	to[FlashAudit::AGENT_NAME_LENGTH] = '\0';
+}
+
+static bool keyLess(const uint8_t *a, const uint8_t *b) {
+	return memcmp(a, b, FlashAudit::COMPRESSED_KEY_LENGTH) < 0;
+}
+
+FlashAudit::FlashAudit(const KeyArchive *registry) :
+		Registry(registry), Badges(), KeyCache(), RegistryKeys(), ContactRefs() {
+}
+
+bool FlashAudit::loadDir(const std::string &dir) {
+	DIR *d = opendir(dir.c_str());
+	if (d == 0) {
+		return false;
+	}
+	std::vector<std::string> names;
+	struct dirent *de;
+	while ((de = readdir(d)) != 0) {
+		if (de->d_name[0] != '.') {
+			names.push_back(de->d_name);
+		}
+	}
+	closedir(d);
+	//report in a stable order
+	std::sort(names.begin(), names.end());
+	for (size_t i = 0; i < names.size(); i++) {
+		std::string path = dir + "/" + names[i];
+		struct stat st;
+		if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+			loadFile(path);
+		}
+	}
+	return true;
+}
+
+void FlashAudit::loadFile(const std::string &fileName) {
+	Badges.push_back(Badge());
+	Badge &b = Badges.back();
+	b.FileName = fileName;
+	b.Legacy = false;
+	b.RadioID = 0;
+	b.Flags = 0;
+	b.NumContacts = 0;
+	b.Problems = UNREADABLE;
+	memset(&b.PrivateKey[0], 0, sizeof(b.PrivateKey));
+	memset(&b.CompressedKey[0], 0, sizeof(b.CompressedKey));
+	memset(&b.PairingHash[0], 0, sizeof(b.PairingHash));
+	b.AgentName[0] = '\0';
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return;
+	}
+	void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) {
+		return;
+	}
+	if (parse(b, (const uint8_t *) p, st.st_size)) {
+		b.Problems &= ~UNREADABLE;
+	}
+	munmap(p, st.st_size);
+}
+
+//same walk as ContactStore::SettingsInfo::init and ContactStore::getContactAt on the badge
+bool FlashAudit::parse(Badge &b, const uint8_t *data, size_t size) {
+	const uint8_t *myInfo;
+	if (size == LEGACY_DUMP_SIZE && readU16(data) == 0xDCDC) {
+		b.Legacy = true;
+		myInfo = data;
+	} else if (size >= DUMP_SIZE) {
+		myInfo = data + MY_INFO_OFFSET;
+	} else {
+		return false;
+	}
+
+	if (readU16(myInfo) == 0xDCDC) {
+		b.RadioID = readU16(myInfo + 2);
+		memcpy(&b.PrivateKey[0], myInfo + 4, sizeof(b.PrivateKey));
+		b.Flags = readU16(myInfo + 28);
+	} else {
+		b.Problems |= NO_MY_INFO;
+	}
+	if (b.Legacy) {
+		return true;
+	}
+
+	const uint8_t *settings = 0;
+	for (uint32_t off = 0; off + SETTINGS_SIZE <= PAGE_SIZE; off += SETTINGS_SIZE) {
+		if (readU16(data + off) == 0xDCDC) {
+			settings = data + off;
+			break;
+		}
+	}
+	if (settings == 0) {
+		b.Problems |= NO_SETTINGS;
+		return true;
+	}
+	b.NumContacts = settings[3];
+	copyName(b.AgentName, settings + 6);
+	if (b.NumContacts > MAX_CONTACTS) {
+		b.Problems |= TOO_MANY_CONTACTS;
+	}
+	uint32_t n = std::min(b.NumContacts, MAX_CONTACTS);
+	b.Contacts.resize(n);
+	for (uint32_t i = 0; i < n; i++) {
+		const uint8_t *rec = data + PAGE_SIZE * (1 + i / CONTACTS_PER_PAGE) + (i % CONTACTS_PER_PAGE) * CONTACT_SIZE;
+		Contact &c = b.Contacts[i];
+		c.RadioID = readU16(rec);
+		memcpy(&c.CompressedKey[0], rec + 2, sizeof(c.CompressedKey));
+		memcpy(&c.Signature[0], rec + 28, sizeof(c.Signature));
+		copyName(c.AgentName, rec + 76);
+		c.Problems = 0;
+	}
+	return true;
+}
+
+//owner key and the hash every contact on the badge signed
+void FlashAudit::ownerWork(uint32_t index, uint32_t, void *ctx) {
+	Badge &b = ((FlashAudit *) ctx)->Badges[index];
+	if (b.Problems & (UNREADABLE | NO_MY_INFO)) {
+		return;
+	}
+	uint8_t publicKey[48];
+	if (uECC_compute_public_key(b.PrivateKey, publicKey, uECC_secp192r1()) != 1) {
+		b.Problems |= BAD_PRIVATE_KEY;
+		return;
+	}
+	uECC_compress(publicKey, b.CompressedKey, uECC_secp192r1());
+	uint8_t id[2] = { (uint8_t) (b.RadioID & 0xFF), (uint8_t) (b.RadioID >> 8) };
+	ShaOBJ shaCtx;
+	sha256_init(&shaCtx);
+	sha256_add(&shaCtx, &id[0], sizeof(id));
+	sha256_add(&shaCtx, &b.CompressedKey[0], sizeof(b.CompressedKey));
+	sha256_digest(&shaCtx, b.PairingHash);
+}
+
+void FlashAudit::registryWork(uint32_t index, uint32_t, void *ctx) {
+	RegistryKey &k = ((FlashAudit *) ctx)->RegistryKeys[index];
+	uint8_t publicKey[48];
+	k.Valid = uECC_compute_public_key(k.MyInfo + 4, publicKey, uECC_secp192r1()) == 1;
+	if (k.Valid) {
+		uECC_compress(publicKey, k.Compressed, uECC_secp192r1());
+	}
+}
+
+void FlashAudit::decompressWork(uint32_t index, uint32_t, void *ctx) {
+	CachedKey &k = ((FlashAudit *) ctx)->KeyCache[index];
+	//only 02/03 prefixes are compressed points, uECC_decompress doesn't check
+	k.Valid = false;
+	if (k.Compressed[0] == 0x02 || k.Compressed[0] == 0x03) {
+		uECC_decompress(k.Compressed, k.PublicKey, uECC_secp192r1());
+		k.Valid = uECC_valid_public_key(k.PublicKey, uECC_secp192r1()) == 1;
+	}
+}
+
+void FlashAudit::verifyWork(uint32_t index, uint32_t, void *ctx) {
+	FlashAudit *fa = (FlashAudit *) ctx;
+	const ContactRef &ref = fa->ContactRefs[index];
+	const Badge &b = fa->Badges[ref.Badge];
+	Contact &c = fa->Badges[ref.Badge].Contacts[ref.Contact];
+	const CachedKey *k = fa->findKey(c.CompressedKey);
+	if (k == 0 || !k->Valid) {
+		c.Problems |= BAD_KEY;
+	} else if (uECC_verify(k->PublicKey, b.PairingHash, sizeof(b.PairingHash), c.Signature, uECC_secp192r1()) != 1) {
+		c.Problems |= BAD_SIGNATURE;
+	}
+}
+
+const FlashAudit::CachedKey *FlashAudit::findKey(const uint8_t compressed[COMPRESSED_KEY_LENGTH]) const {
+	size_t lo = 0, hi = KeyCache.size();
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		int cmp = memcmp(KeyCache[mid].Compressed, compressed, COMPRESSED_KEY_LENGTH);
+		if (cmp == 0) {
+			return &KeyCache[mid];
+		} else if (cmp < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return 0;
+}
+
+const FlashAudit::RegistryKey *FlashAudit::findRegistryKey(uint16_t id) const {
+	size_t lo = 0, hi = RegistryKeys.size();
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (RegistryKeys[mid].RadioID == id) {
+			return RegistryKeys[mid].Valid ? &RegistryKeys[mid] : 0;
+		} else if (RegistryKeys[mid].RadioID < id) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return 0;
+}
+
+struct CachedKeyLess {
+	template<typename T> bool operator()(const T &a, const T &b) const {
+		return keyLess(a.Compressed, b.Compressed);
+	}
+};
+
+struct CachedKeyEqual {
+	template<typename T> bool operator()(const T &a, const T &b) const {
+		return memcmp(a.Compressed, b.Compressed, FlashAudit::COMPRESSED_KEY_LENGTH) == 0;
+	}
+};
+
+void FlashAudit::run(WorkerPool &pool) {
+	pool.run(Badges.size(), ownerWork, this, 1);
+
+	//every distinct contact key once, no matter how many badges paired with it
+	KeyCache.clear();
+	ContactRefs.clear();
+	std::vector<uint16_t> ids;
+	for (uint32_t bi = 0; bi < Badges.size(); bi++) {
+		const Badge &b = Badges[bi];
+		ids.push_back(b.RadioID);
+		for (uint32_t ci = 0; ci < b.Contacts.size(); ci++) {
+			CachedKey k;
+			memcpy(&k.Compressed[0], &b.Contacts[ci].CompressedKey[0], sizeof(k.Compressed));
+			k.Valid = false;
+			KeyCache.push_back(k);
+			ids.push_back(b.Contacts[ci].RadioID);
+			if ((b.Problems & NO_OWNER_PROBLEMS) == 0) {
+				ContactRef ref = { bi, ci };
+				ContactRefs.push_back(ref);
+			}
+		}
+	}
+	std::sort(KeyCache.begin(), KeyCache.end(), CachedKeyLess());
+	KeyCache.erase(std::unique(KeyCache.begin(), KeyCache.end(), CachedKeyEqual()), KeyCache.end());
+	pool.run(KeyCache.size(), decompressWork, this);
+
+	//provisioned keys for every radio id the dumps mention
+	RegistryKeys.clear();
+	if (Registry) {
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		for (size_t i = 0; i < ids.size(); i++) {
+			const uint8_t *myInfo = Registry->find(ids[i]);
+			if (myInfo) {
+				RegistryKey k;
+				k.RadioID = ids[i];
+				k.MyInfo = myInfo;
+				k.Valid = false;
+				RegistryKeys.push_back(k);
+			}
+		}
+		pool.run(RegistryKeys.size(), registryWork, this);
+	}
+
+	pool.run(ContactRefs.size(), verifyWork, this);
+	crossCheck();
+}
+
+void FlashAudit::crossCheck() {
+	//who owns which key: the archive if we have it, else the badge's own dump
+	std::map<uint16_t, const uint8_t *> owners;
+	for (size_t i = 0; i < RegistryKeys.size(); i++) {
+		if (RegistryKeys[i].Valid) {
+			owners[RegistryKeys[i].RadioID] = RegistryKeys[i].Compressed;
+		}
+	}
+	std::map<uint16_t, size_t> dumped;
+	for (size_t bi = 0; bi < Badges.size(); bi++) {
+		Badge &b = Badges[bi];
+		if (b.Problems & NO_OWNER_PROBLEMS) {
+			continue;
+		}
+		if (Registry) {
+			const RegistryKey *k = findRegistryKey(b.RadioID);
+			if (k == 0 || memcmp(k->Compressed, b.CompressedKey, COMPRESSED_KEY_LENGTH) != 0) {
+				b.Problems |= NOT_PROVISIONED;
+			}
+		}
+		//two dumps claiming one radio id with different keys, one of them is a copy
+		std::map<uint16_t, size_t>::iterator it = dumped.find(b.RadioID);
+		if (it == dumped.end()) {
+			dumped[b.RadioID] = bi;
+		} else if (memcmp(Badges[it->second].CompressedKey, b.CompressedKey, COMPRESSED_KEY_LENGTH) != 0) {
+			Badges[it->second].Problems |= CLONED;
+			b.Problems |= CLONED;
+		}
+		if (owners.find(b.RadioID) == owners.end()) {
+			owners[b.RadioID] = b.CompressedKey;
+		}
+	}
+
+	//without an owner, the first key seen for an id is compared against every other claim
+	std::map<uint16_t, const uint8_t *> claims;
+	std::map<uint16_t, bool> conflicted;
+	for (size_t bi = 0; bi < Badges.size(); bi++) {
+		Badge &b = Badges[bi];
+		std::map<uint16_t, bool> seen;
+		for (size_t ci = 0; ci < b.Contacts.size(); ci++) {
+			Contact &c = b.Contacts[ci];
+			if (c.RadioID == 0 || c.RadioID == 0xFFFF || ((b.Problems & NO_OWNER_PROBLEMS) == 0 && c.RadioID == b.RadioID)) {
+				c.Problems |= BAD_RADIO_ID;
+			}
+			if (seen.find(c.RadioID) != seen.end()) {
+				c.Problems |= DUPLICATE;
+			}
+			seen[c.RadioID] = true;
+			std::map<uint16_t, const uint8_t *>::iterator owner = owners.find(c.RadioID);
+			if (owner != owners.end()) {
+				if (memcmp(owner->second, c.CompressedKey, COMPRESSED_KEY_LENGTH) != 0) {
+					c.Problems |= FORGED;
+				}
+			} else {
+				std::map<uint16_t, const uint8_t *>::iterator claim = claims.find(c.RadioID);
+				if (claim == claims.end()) {
+					claims[c.RadioID] = c.CompressedKey;
+				} else if (memcmp(claim->second, c.CompressedKey, COMPRESSED_KEY_LENGTH) != 0) {
+					conflicted[c.RadioID] = true;
+				}
+			}
+		}
+	}
+	for (size_t bi = 0; bi < Badges.size(); bi++) {
+		for (size_t ci = 0; ci < Badges[bi].Contacts.size(); ci++) {
+			Contact &c = Badges[bi].Contacts[ci];
+			if (conflicted.find(c.RadioID) != conflicted.end()) {
+				c.Problems |= KEY_CONFLICT;
+			}
+		}
+	}
+}
+
+static std::string badgeProblems(uint32_t p) {
+	std::string s;
+	if (p & FlashAudit::UNREADABLE)
+		s += " unreadable (expected 0x1c00 bytes from 0x800e400)";
+	if (p & FlashAudit::NO_MY_INFO)
+		s += " no MyInfo block";
+	if (p & FlashAudit::BAD_PRIVATE_KEY)
+		s += " private key is not a valid scalar";
+	if (p & FlashAudit::NO_SETTINGS)
+		s += " no settings record";
+	if (p & FlashAudit::TOO_MANY_CONTACTS)
+		s += " contact count past 66";
+	if (p & FlashAudit::NOT_PROVISIONED)
+		s += " key doesn't match the archive";
+	if (p & FlashAudit::CLONED)
+		s += " another dump has this radio id with a different key";
+	return s;
+}
+
+static std::string contactProblems(uint32_t p) {
+	std::string s;
+	if (p & FlashAudit::BAD_RADIO_ID)
+		s += " invalid radio id";
+	if (p & FlashAudit::BAD_KEY)
+		s += " invalid public key";
+	if (p & FlashAudit::BAD_SIGNATURE)
+		s += " invalid signature";
+	if (p & FlashAudit::DUPLICATE)
+		s += " duplicate";
+	if (p & FlashAudit::FORGED)
+		s += " forged (not the provisioned key)";
+	if (p & FlashAudit::KEY_CONFLICT)
+		s += " forged (dumps disagree on the key)";
+	return s;
+}
+
+FlashAudit::Summary FlashAudit::report(std::ostream &out) const {
+	Summary sum = { 0, 0, 0, 0, 0, 0 };
+	for (size_t bi = 0; bi < Badges.size(); bi++) {
+		const Badge &b = Badges[bi];
+		sum.NumBadges++;
+		out << b.FileName << ": ";
+		if (b.Problems & (UNREADABLE | NO_MY_INFO)) {
+			out << "?";
+		} else {
+			out << radioIDName(b.RadioID);
+		}
+		if (b.Legacy) {
+			out << " MyInfo only (old 0x1800 dump from 0x800ffd4)";
+		} else if ((b.Problems & UNREADABLE) == 0) {
+			out << " \"" << b.AgentName << "\" " << b.Contacts.size() << " contacts";
+		}
+		if (b.Problems) {
+			sum.NumBadBadges++;
+			out << ":" << badgeProblems(b.Problems);
+		}
+		out << "\n";
+		for (size_t ci = 0; ci < b.Contacts.size(); ci++) {
+			const Contact &c = b.Contacts[ci];
+			sum.NumContacts++;
+			if (c.Problems & INVALID_PROBLEMS)
+				sum.NumInvalid++;
+			if (c.Problems & DUPLICATE)
+				sum.NumDuplicate++;
+			if (c.Problems & FORGED_PROBLEMS)
+				sum.NumForged++;
+			if (c.Problems) {
+				out << "\tcontact " << ci << " " << radioIDName(c.RadioID) << " \"" << c.AgentName << "\":"
+						<< contactProblems(c.Problems) << "\n";
+			}
+		}
+	}
+	out << sum.NumBadges << " dumps, " << sum.NumBadBadges << " with badge problems, " << sum.NumContacts
+			<< " contacts: " << sum.NumInvalid << " invalid, " << sum.NumDuplicate << " duplicate, " << sum.NumForged
+			<< " forged" << std::endl;
+	return sum;
+}
+
+const std::vector<FlashAudit::Badge> &FlashAudit::getBadges() const {
+	return Badges;
+}
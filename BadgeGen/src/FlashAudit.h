@@ -0,0 +1,124 @@
+#ifndef FLASH_AUDIT_H
+#define FLASH_AUDIT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "KeyArchive.h"
+#include "WorkerPool.h"
+
+//Offline audit of badge flash dumps pulled with openocd (see commands.txt).
+//A dump is the whole ContactStore, 7 pages from 0x800E400, little endian like the badge:
+//		[0x0000-0x03FF] sector 57: ring of 18 byte settings records, the live one starts 0xDCDC
+//						[2] reserved [3] number of contacts [4-5] screen saver/sleep [6-17] agent name
+//		[0x0400-0x1BFF] sectors 58-63: 11 contacts of 88 bytes per sector
+//						[0-1] radio id [2-27] compressed public key [28-75] signature [76-87] agent name
+//		[0x1BD4-0x1BF1] MyInfo at 0x800FFD4: 0xdcdc, radio id, private key, flags
+//Dumps taken the old way (0x1800 bytes from 0x800FFD4) only hold MyInfo and are checked for that alone.
+//
+//Every contact's pairing signature is the contact's signature of sha256(owner radio id | owner compressed
+//key), it is verified against the contact's stored key. Keys are decompressed once into a shared cache
+//and the signature checks are spread across the pool.
+//A contact is reported when:
+//	invalid		blank/reserved radio id, key not on the curve or the signature doesn't verify
+//	duplicate	the same radio id is stored more than once on one badge
+//	forged		its key isn't the key that radio id was provisioned with (from -a or that badge's own dump),
+//				or without either, different dumps hold different keys for it
+class FlashAudit {
+public:
+	static const uint32_t PAGE_SIZE = 1024;
+	static const uint32_t STORE_ADDRESS = 0x800E400;
+	static const uint32_t NUM_CONTACT_PAGES = 6;
+	static const uint32_t DUMP_SIZE = PAGE_SIZE * (1 + NUM_CONTACT_PAGES);
+	static const uint32_t MY_INFO_ADDRESS = 0x800FFD4;
+	static const uint32_t LEGACY_DUMP_SIZE = 0x1800;
+	static const uint32_t SETTINGS_SIZE = 18;
+	static const uint32_t CONTACT_SIZE = 88;
+	static const uint32_t CONTACTS_PER_PAGE = PAGE_SIZE / CONTACT_SIZE;
+	static const uint32_t MAX_CONTACTS = 66;
+	static const uint32_t COMPRESSED_KEY_LENGTH = 25;
+	static const uint32_t SIGNATURE_LENGTH = 48;
+	static const uint32_t AGENT_NAME_LENGTH = 12;
+
+	enum CONTACT_PROBLEM {
+		BAD_RADIO_ID = 0x1, BAD_KEY = 0x2, BAD_SIGNATURE = 0x4, DUPLICATE = 0x8, FORGED = 0x10, KEY_CONFLICT = 0x20
+	};
+	enum BADGE_PROBLEM {
+		UNREADABLE = 0x1, NO_MY_INFO = 0x2, BAD_PRIVATE_KEY = 0x4, NO_SETTINGS = 0x8, TOO_MANY_CONTACTS = 0x10,
+		NOT_PROVISIONED = 0x20, CLONED = 0x40
+	};
+
+	struct Contact {
+		uint16_t RadioID;
+		uint8_t CompressedKey[COMPRESSED_KEY_LENGTH];
+		uint8_t Signature[SIGNATURE_LENGTH];
+		char AgentName[AGENT_NAME_LENGTH + 1];
+		uint32_t Problems;
+	};
+
+	struct Badge {
+		std::string FileName;
+		bool Legacy;
+		uint16_t RadioID;
+		uint8_t PrivateKey[24];
+		uint16_t Flags;
+		//computed from PrivateKey
+		uint8_t CompressedKey[COMPRESSED_KEY_LENGTH];
+		//what every contact on this badge signed
+		uint8_t PairingHash[32];
+		char AgentName[AGENT_NAME_LENGTH + 1];
+		uint32_t NumContacts;
+		std::vector<Contact> Contacts;
+		uint32_t Problems;
+	};
+
+	struct Summary {
+		uint32_t NumBadges, NumContacts, NumInvalid, NumDuplicate, NumForged, NumBadBadges;
+	};
+public:
+	//registry, if not 0, is the provisioning archive: the source of truth for which key belongs to a radio id
+	FlashAudit(const KeyArchive *registry);
+	//mmaps and parses every regular file in dir, returns false if dir can't be read
+	bool loadDir(const std::string &dir);
+	void loadFile(const std::string &fileName);
+	//all the crypto, then the cross badge checks
+	void run(WorkerPool &pool);
+	//one line per problem, then the totals
+	Summary report(std::ostream &out) const;
+	const std::vector<Badge> &getBadges() const;
+private:
+	struct CachedKey {
+		uint8_t Compressed[COMPRESSED_KEY_LENGTH];
+		uint8_t PublicKey[48];
+		bool Valid;
+	};
+	struct ContactRef {
+		uint32_t Badge;
+		uint32_t Contact;
+	};
+	struct RegistryKey {
+		uint16_t RadioID;
+		const uint8_t *MyInfo;
+		uint8_t Compressed[COMPRESSED_KEY_LENGTH];
+		bool Valid;
+	};
+	bool parse(Badge &b, const uint8_t *data, size_t size);
+	const CachedKey *findKey(const uint8_t compressed[COMPRESSED_KEY_LENGTH]) const;
+	const RegistryKey *findRegistryKey(uint16_t id) const;
+	void crossCheck();
+	static void ownerWork(uint32_t index, uint32_t worker, void *ctx);
+	static void registryWork(uint32_t index, uint32_t worker, void *ctx);
+	static void decompressWork(uint32_t index, uint32_t worker, void *ctx);
+	static void verifyWork(uint32_t index, uint32_t worker, void *ctx);
+private:
+	const KeyArchive *Registry;
+	std::vector<Badge> Badges;
+	//sorted by compressed key, filled once before the verify pass and read only after
+	std::vector<CachedKey> KeyCache;
+	//key each radio id seen in the dumps was provisioned with, from Registry, sorted by id
+	std::vector<RegistryKey> RegistryKeys;
+	std::vector<ContactRef> ContactRefs;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "KeyArchive.h"
+#include "sha256.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const uint8_t MAGIC[4] = { 'D', 'C', 'K', 'A' };
+
+KeyArchive::KeyArchive() :
+		Data(0), Size(0), NumRecords(0) {
+}
+
+KeyArchive::~KeyArchive() {
+	close();
+}
+
+KeyArchive::ERROR KeyArchive::open(const std::string &fileName, bool verify) {
+	close();
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return OPEN_FAILED;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return OPEN_FAILED;
+	}
+	if ((size_t) st.st_size < HEADER_SIZE + CHECKSUM_SIZE) {
+		::close(fd);
+		return BAD_SIZE;
+	}
+	void *p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) {
+		return OPEN_FAILED;
+	}
+	Data = (const uint8_t *) p;
+	Size = st.st_size;
+
+	Header h;
+	memcpy(&h, Data, sizeof(h));
+	ERROR e = NO_ERROR;
+	if (memcmp(&h.Magic[0], &MAGIC[0], sizeof(MAGIC)) != 0 || h.Version != VERSION || h.RecordSize != RECORD_SIZE) {
+		e = BAD_HEADER;
+	} else if (Size != HEADER_SIZE + (size_t) h.NumRecords * RECORD_SIZE + CHECKSUM_SIZE) {
+		e = BAD_SIZE;
+	} else {
+		NumRecords = h.NumRecords;
+		if (verify && !verifyChecksum()) {
+			e = BAD_CHECKSUM;
+		} else {
+			for (uint32_t i = 1; i < NumRecords; i++) {
+				if (getRadioID(i - 1) >= getRadioID(i)) {
+					e = NOT_SORTED;
+					break;
+				}
+			}
+		}
+	}
+	if (e != NO_ERROR) {
+		close();
+	}
+	return e;
+}
+
+void KeyArchive::close() {
+	if (Data) {
+		munmap((void *) Data, Size);
+	}
+	Data = 0;
+	Size = 0;
+	NumRecords = 0;
+}
+
+bool KeyArchive::isOpen() const {
+	return Data != 0;
+}
+
+uint32_t KeyArchive::getNumRecords() const {
+	return NumRecords;
+}
+
+const uint8_t *KeyArchive::getRecord(uint32_t n) const {
+	return Data + HEADER_SIZE + (size_t) n * RECORD_SIZE;
+}
+
+uint16_t KeyArchive::getRadioID(uint32_t n) const {
+	const uint8_t *r = getRecord(n);
+	return r[2] | (r[3] << 8);
+}
+
+const uint8_t *KeyArchive::find(uint16_t radioID) const {
+	uint32_t low = 0, high = NumRecords;
+	while (low < high) {
+		uint32_t mid = low + (high - low) / 2;
+		uint16_t id = getRadioID(mid);
+		if (id == radioID) {
+			return getRecord(mid);
+		} else if (id < radioID) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return 0;
+}
+
+bool KeyArchive::verifyChecksum() const {
+	if (!Data) {
+		return false;
+	}
+	ShaOBJ shaCtx;
+	sha256_init(&shaCtx);
+	sha256_add(&shaCtx, Data, Size - CHECKSUM_SIZE);
+	uint8_t digest[CHECKSUM_SIZE];
+	sha256_digest(&shaCtx, digest);
+	return memcmp(&digest[0], Data + Size - CHECKSUM_SIZE, CHECKSUM_SIZE) == 0;
+}
+
+struct RadioIDLess {
+	const std::vector<BadgeRecord> &Records;
+	RadioIDLess(const std::vector<BadgeRecord> &r) :
+			Records(r) {
+	}
+	bool operator()(uint32_t a, uint32_t b) const {
+		return Records[a].getRadioID() < Records[b].getRadioID();
+	}
+};
+
+KeyArchive::ERROR KeyArchive::write(const std::string &fileName, const KeyArchive *existing,
+		const std::vector<BadgeRecord> &newRecords) {
+	std::vector<uint32_t> order;
+	order.reserve(newRecords.size());
+	for (uint32_t i = 0; i < newRecords.size(); i++) {
+		if (newRecords[i].Valid) {
+			order.push_back(i);
+		}
+	}
+	std::sort(order.begin(), order.end(), RadioIDLess(newRecords));
+	uint32_t numExisting = (existing && existing->isOpen()) ? existing->getNumRecords() : 0;
+
+	std::string tmpName = fileName + ".tmp";
+	FILE *f = fopen(tmpName.c_str(), "wb");
+	if (!f) {
+		return OPEN_FAILED;
+	}
+	setvbuf(f, 0, _IOFBF, 1 << 20);
+	ShaOBJ shaCtx;
+	sha256_init(&shaCtx);
+
+	Header h;
+	memcpy(&h.Magic[0], &MAGIC[0], sizeof(MAGIC));
+	h.Version = VERSION;
+	h.RecordSize = RECORD_SIZE;
+	h.NumRecords = numExisting + order.size();
+	h.Reserved = 0;
+	fwrite(&h, sizeof(h), 1, f);
+	sha256_add(&shaCtx, (const uint8_t *) &h, sizeof(h));
+
+	//merge the two sorted lists
+	uint32_t e = 0, n = 0;
+	uint8_t block[RECORD_SIZE];
+	while (e < numExisting || n < order.size()) {
+		const uint8_t *r;
+		if (n == order.size() || (e < numExisting && existing->getRadioID(e) < newRecords[order[n]].getRadioID())) {
+			r = existing->getRecord(e++);
+		} else {
+			newRecords[order[n++]].getMyInfo(block);
+			r = &block[0];
+		}
+		fwrite(r, RECORD_SIZE, 1, f);
+		sha256_add(&shaCtx, r, RECORD_SIZE);
+	}
+
+	uint8_t digest[CHECKSUM_SIZE];
+	sha256_digest(&shaCtx, digest);
+	fwrite(&digest[0], sizeof(digest), 1, f);
+	bool ok = !ferror(f);
+	ok = (fclose(f) == 0) && ok;
+	if (!ok || rename(tmpName.c_str(), fileName.c_str()) != 0) {
+		unlink(tmpName.c_str());
+		return WRITE_FAILED;
+	}
+	return NO_ERROR;
+}
+
+const char *KeyArchive::errorString(ERROR e) {
+	switch (e) {
+	case NO_ERROR:
+		return "no error";
+	case OPEN_FAILED:
+		return "could not open archive";
+	case BAD_SIZE:
+		return "archive size does not match its header";
+	case BAD_HEADER:
+		return "not a key archive";
+	case BAD_CHECKSUM:
+		return "archive checksum mismatch";
+	case NOT_SORTED:
+		return "archive records are not sorted by radio id";
+	case WRITE_FAILED:
+		return "could not write archive";
+	}
+	return "unknown error";
+}
@@ -0,0 +1,57 @@
+#ifndef KEY_ARCHIVE_H
+#define KEY_ARCHIVE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "BadgeRecord.h"
+
+//Packed provisioning archive, replaces one ./keys/<radioid> file per badge.
+//Everything is little endian, same as the badge.
+//		[0-15]	header (see Header)
+//		[16-..]	NumRecords MyInfo blocks (BadgeRecord::MY_INFO_SIZE bytes each) sorted by radio id
+//		[last 32] sha256 of everything before it
+//The file is written in one sequential pass and is meant to be mmap'ed, lookups are a binary
+//search over the record table.
+class KeyArchive {
+public:
+	static const uint16_t VERSION = 1;
+	static const uint32_t HEADER_SIZE = 16;
+	static const uint32_t CHECKSUM_SIZE = 32;
+	static const uint32_t RECORD_SIZE = BadgeRecord::MY_INFO_SIZE;
+	struct Header {
+		uint8_t Magic[4]; //DCKA
+		uint16_t Version;
+		uint16_t RecordSize;
+		uint32_t NumRecords;
+		uint32_t Reserved;
+	};
+	enum ERROR {
+		NO_ERROR, OPEN_FAILED, BAD_SIZE, BAD_HEADER, BAD_CHECKSUM, NOT_SORTED, WRITE_FAILED
+	};
+public:
+	KeyArchive();
+	~KeyArchive();
+	ERROR open(const std::string &fileName, bool verifyChecksum = true);
+	void close();
+	bool isOpen() const;
+	uint32_t getNumRecords() const;
+	const uint8_t *getRecord(uint32_t n) const;
+	uint16_t getRadioID(uint32_t n) const;
+	//the MyInfo block for radioID or 0 if it isn't in the archive
+	const uint8_t *find(uint16_t radioID) const;
+	bool verifyChecksum() const;
+	//writes existing (if open) merged with newRecords, radio ids in newRecords must not be in existing
+	//written to fileName + ".tmp" then renamed over fileName so readers never see a partial file
+	static ERROR write(const std::string &fileName, const KeyArchive *existing, const std::vector<BadgeRecord> &newRecords);
+	static const char *errorString(ERROR e);
+private:
+	KeyArchive(const KeyArchive &);
+	KeyArchive &operator=(const KeyArchive &);
+private:
+	const uint8_t *Data;
+	size_t Size;
+	uint32_t NumRecords;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "KeyDerivation.h"
+#include <uECC.h>
+#include <string.h>
+
+static const uint32 SHA256_BLOCK_SIZE = 64;
+static const char SEED_SALT[] = "DCDarkNet badge seed v1";
+static const char PRIVATE_KEY_INFO[] = "badge private key";
+static const char RADIO_ID_INFO[] = "badge radio id";
+
+void hmac_sha256(const uint8_t *key, uint32 keyLen, const uint8_t *msg, uint32 msgLen, uint8_t mac[HMAC_SHA256_SIZE]) {
+	uint8_t k[SHA256_BLOCK_SIZE];
+	memset(&k[0], 0, sizeof(k));
+	if (keyLen > SHA256_BLOCK_SIZE) {
+		ShaOBJ keyCtx;
+		sha256_init(&keyCtx);
+		sha256_add(&keyCtx, key, keyLen);
+		sha256_digest(&keyCtx, k);
+	} else {
+		memcpy(&k[0], key, keyLen);
+	}
+	uint8_t pad[SHA256_BLOCK_SIZE];
+	uint8_t inner[HMAC_SHA256_SIZE];
+	ShaOBJ ctx;
+
+	for (uint32 i = 0; i < SHA256_BLOCK_SIZE; i++) {
+		pad[i] = k[i] ^ 0x36;
+	}
+	sha256_init(&ctx);
+	sha256_add(&ctx, pad, sizeof(pad));
+	sha256_add(&ctx, msg, msgLen);
+	sha256_digest(&ctx, inner);
+
+	for (uint32 i = 0; i < SHA256_BLOCK_SIZE; i++) {
+		pad[i] = k[i] ^ 0x5c;
+	}
+	sha256_init(&ctx);
+	sha256_add(&ctx, pad, sizeof(pad));
+	sha256_add(&ctx, inner, sizeof(inner));
+	sha256_digest(&ctx, mac);
+}
+
+void hkdf_sha256_extract(const uint8_t *salt, uint32 saltLen, const uint8_t *ikm, uint32 ikmLen,
+		uint8_t prk[HMAC_SHA256_SIZE]) {
+	hmac_sha256(salt, saltLen, ikm, ikmLen, prk);
+}
+
+bool hkdf_sha256_expand(const uint8_t prk[HMAC_SHA256_SIZE], const uint8_t *info, uint32 infoLen, uint8_t *out,
+		uint32 outLen) {
+	//T(n) = HMAC(PRK, T(n-1) | info | n)
+	uint8_t block[HMAC_SHA256_SIZE + HKDF_MAX_INFO + 1];
+	uint8_t t[HMAC_SHA256_SIZE];
+	uint32 tLen = 0;
+	uint8_t counter = 1;
+	//truncating info would give two different infos the same key
+	if (infoLen > HKDF_MAX_INFO || outLen > 255 * HMAC_SHA256_SIZE) {
+		return false;
+	}
+	while (outLen > 0) {
+		memcpy(&block[0], &t[0], tLen);
+		memcpy(&block[tLen], info, infoLen);
+		block[tLen + infoLen] = counter++;
+		hmac_sha256(prk, HMAC_SHA256_SIZE, block, tLen + infoLen + 1, t);
+		tLen = HMAC_SHA256_SIZE;
+		uint32 n = outLen < HMAC_SHA256_SIZE ? outLen : HMAC_SHA256_SIZE;
+		memcpy(out, &t[0], n);
+		out += n;
+		outLen -= n;
+	}
+	return true;
+}
+
+//the allocator gets its round keys up front and never draws any from the rng
+SeedKeyDeriver::SeedKeyDeriver(const uint8_t *seed, uint32 seedLen) :
+		PRK(), RadioIDs(deriveRoundKeys(seed, seedLen, PRK).Keys) {
+}
+
+SeedKeyDeriver::RoundKeys SeedKeyDeriver::deriveRoundKeys(const uint8_t *seed, uint32 seedLen,
+		uint8_t prk[HMAC_SHA256_SIZE]) {
+	hkdf_sha256_extract((const uint8_t *) SEED_SALT, sizeof(SEED_SALT) - 1, seed, seedLen, prk);
+	uint8_t keyBytes[RadioIDAllocator::FEISTEL_ROUNDS * 4];
+	hkdf_sha256_expand(prk, (const uint8_t *) RADIO_ID_INFO, sizeof(RADIO_ID_INFO) - 1, keyBytes, sizeof(keyBytes));
+	RoundKeys keys;
+	for (int i = 0; i < RadioIDAllocator::FEISTEL_ROUNDS; i++) {
+		keys.Keys[i] = (keyBytes[i * 4] << 24) | (keyBytes[i * 4 + 1] << 16) | (keyBytes[i * 4 + 2] << 8)
+				| keyBytes[i * 4 + 3];
+	}
+	return keys;
+}
+
+bool SeedKeyDeriver::derivePrivateKey(uint32_t index, uint8_t privKey[24], uint8_t pubKey[48]) const {
+	if (index >= MAX_INDEX) {
+		return false;
+	}
+	const uint32 labelLen = sizeof(PRIVATE_KEY_INFO) - 1;
+	uint8_t info[sizeof(PRIVATE_KEY_INFO) - 1 + 5];
+	memcpy(&info[0], PRIVATE_KEY_INFO, labelLen);
+	info[labelLen] = index >> 24;
+	info[labelLen + 1] = index >> 16;
+	info[labelLen + 2] = index >> 8;
+	info[labelLen + 3] = index;
+	//n for secp192r1 is just under 2^192 so a retry is astronomically rare, but it has to be deterministic
+	for (int attempt = 0; attempt < 256; attempt++) {
+		info[labelLen + 4] = attempt;
+		if (!hkdf_sha256_expand(PRK, info, sizeof(info), privKey, 24)) {
+			return false;
+		}
+		if (uECC_compute_public_key(privKey, pubKey, uECC_secp192r1()) == 1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SeedKeyDeriver::deriveRadioID(uint32_t index, uint8_t RadioID[2]) const {
+	uint16_t id;
+	if (!RadioIDs.getIDForIndex(index, id)) {
+		return false;
+	}
+	RadioID[0] = id & 0xFF;
+	RadioID[1] = id >> 8;
+	return true;
+}
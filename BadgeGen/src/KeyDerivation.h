@@ -0,0 +1,45 @@
+#ifndef KEY_DERIVATION_H
+#define KEY_DERIVATION_H
+
+#include <stdint.h>
+#include "sha256.h"
+#include "RadioIDAllocator.h"
+
+static const uint32 HMAC_SHA256_SIZE = 32;
+
+//RFC 2104 / RFC 5869 on top of sha256.cpp
+void hmac_sha256(const uint8_t *key, uint32 keyLen, const uint8_t *msg, uint32 msgLen, uint8_t mac[HMAC_SHA256_SIZE]);
+void hkdf_sha256_extract(const uint8_t *salt, uint32 saltLen, const uint8_t *ikm, uint32 ikmLen,
+		uint8_t prk[HMAC_SHA256_SIZE]);
+//info is at most HKDF_MAX_INFO bytes, it's kept on the stack. false (and out untouched) for a longer info or an
+//outLen over 255*32
+static const uint32 HKDF_MAX_INFO = 64;
+bool hkdf_sha256_expand(const uint8_t prk[HMAC_SHA256_SIZE], const uint8_t *info, uint32 infoLen, uint8_t *out,
+		uint32 outLen);
+
+//Derives every badge's private key and radio id from a master seed and the badge index, so any index
+//range can be generated on any machine, in any number of pieces, and come out byte identical.
+//	private key = HKDF-Expand(PRK, "badge private key" | index | attempt, 24), first attempt that is a valid scalar
+//	radio id = keyed permutation (round keys from HKDF-Expand(PRK, "badge radio id")) of the index, so
+//			   ids never collide inside one seed
+class SeedKeyDeriver {
+public:
+	//index space is every radio id except 0x0000 and 0xFFFF
+	static const uint32_t MAX_INDEX = RadioIDAllocator::ID_SPACE - 2;
+public:
+	SeedKeyDeriver(const uint8_t *seed, uint32 seedLen);
+	bool derivePrivateKey(uint32_t index, uint8_t privKey[24], uint8_t pubKey[48]) const;
+	bool deriveRadioID(uint32_t index, uint8_t RadioID[2]) const;
+private:
+	struct RoundKeys {
+		uint32_t Keys[RadioIDAllocator::FEISTEL_ROUNDS];
+	};
+	//extracts prk from the seed and expands the allocator's round keys from it
+	static RoundKeys deriveRoundKeys(const uint8_t *seed, uint32 seedLen, uint8_t prk[HMAC_SHA256_SIZE]);
+private:
+	//declared before RadioIDs, its round keys are derived from it
+	uint8_t PRK[HMAC_SHA256_SIZE];
+	RadioIDAllocator RadioIDs;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "RadioIDAllocator.h"
+#include <uECC.h>
+#include <string.h>
+#include <dirent.h>
+
+RadioIDAllocator::RadioIDAllocator(const uint32_t roundKeys[FEISTEL_ROUNDS]) :
+		RoundKeys(), Used(), NumUsed(0), Counter(0) {
+	if (roundKeys) {
+		memcpy(&RoundKeys[0], &roundKeys[0], sizeof(RoundKeys));
+	} else {
+		uECC_RNG_Function f = uECC_get_rng();
+		f((uint8_t *) &RoundKeys[0], sizeof(RoundKeys));
+	}
+	memset(&Used[0], 0, sizeof(Used));
+	markUsed(0x0000);
+	markUsed(0xFFFF);
+}
+
+static int hexValue(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+bool RadioIDAllocator::parseKeyFileName(const char *name, uint16_t &id) {
+	size_t len = strlen(name);
+	if (len < 3 || len > 4) {
+		return false;
+	}
+	int v[4] = { 0 };
+	for (size_t i = 0; i < len; i++) {
+		if ((v[i] = hexValue(name[i])) < 0) {
+			return false;
+		}
+	}
+	uint8_t first = (v[0] << 4) | v[1];
+	uint8_t second = len == 3 ? v[2] : ((v[2] << 4) | v[3]);
+	//a padded second byte < 0x10 can't have been written by us
+	if (len == 4 && v[2] == 0) {
+		return false;
+	}
+	id = first | (second << 8);
+	return true;
+}
+
+bool RadioIDAllocator::loadKeyDir(const std::string &keyDir) {
+	DIR *dir = opendir(keyDir.c_str());
+	if (dir == 0) {
+		return false;
+	}
+	struct dirent *de;
+	while ((de = readdir(dir)) != 0) {
+		uint16_t id;
+		if (parseKeyFileName(de->d_name, id)) {
+			markUsed(id);
+		}
+	}
+	closedir(dir);
+	return true;
+}
+
+void RadioIDAllocator::markUsed(uint16_t id) {
+	if (!isUsed(id)) {
+		Used[id >> 3] |= (1 << (id & 7));
+		NumUsed++;
+	}
+}
+
+bool RadioIDAllocator::isUsed(uint16_t id) const {
+	return (Used[id >> 3] & (1 << (id & 7))) != 0;
+}
+
+uint32_t RadioIDAllocator::getNumFree() const {
+	return ID_SPACE - NumUsed;
+}
+
+uint16_t RadioIDAllocator::permute(uint16_t x) const {
+	uint8_t left = x >> 8;
+	uint8_t right = x & 0xFF;
+	for (int i = 0; i < FEISTEL_ROUNDS; i++) {
+		uint32_t t = (right + RoundKeys[i]) * 0x9E3779B1;
+		t ^= t >> 15;
+		uint8_t next = left ^ (t >> 24);
+		left = right;
+		right = next;
+	}
+	return (left << 8) | right;
+}
+
+bool RadioIDAllocator::allocate(uint16_t &id) {
+	while (Counter < ID_SPACE) {
+		uint16_t candidate = permute(Counter++);
+		if (!isUsed(candidate)) {
+			markUsed(candidate);
+			id = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool RadioIDAllocator::getIDForIndex(uint32_t index, uint16_t &id) const {
+	static const uint32_t NUM_IDS = ID_SPACE - 2;
+	if (index >= NUM_IDS) {
+		return false;
+	}
+	uint32_t x = index;
+	do {
+		x = permute(x);
+	} while (x >= NUM_IDS);
+	id = x + 1;
+	return true;
+}
+
+bool RadioIDAllocator::allocate(uint8_t RadioID[2]) {
+	uint16_t id;
+	if (allocate(id)) {
+		RadioID[0] = id & 0xFF;
+		RadioID[1] = id >> 8;
+		return true;
+	}
+	return false;
+}
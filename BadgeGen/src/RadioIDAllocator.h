@@ -0,0 +1,41 @@
+#ifndef RADIO_ID_ALLOCATOR_H
+#define RADIO_ID_ALLOCATOR_H
+
+#include <stdint.h>
+#include <string>
+
+//Hands out unused 16 bit radio ids without touching the file system per id.
+//Used ids are loaded once into a 64K bitmap, new ids are walked in the order of a keyed
+//random permutation of the id space (small feistel network) so every id is visited at most
+//once: no retries, no matter how full the space is.
+//0x0000 (means no contact on the badge) and 0xFFFF (erased flash) are never handed out.
+class RadioIDAllocator {
+public:
+	static const uint32_t ID_SPACE = 0x10000;
+	static const uint8_t FEISTEL_ROUNDS = 4;
+public:
+	//roundKeys of 0 draws a key from the uECC rng
+	RadioIDAllocator(const uint32_t roundKeys[FEISTEL_ROUNDS] = 0);
+	//marks every id that already has a key file in keyDir as used, a missing dir is fine
+	bool loadKeyDir(const std::string &keyDir);
+	void markUsed(uint16_t id);
+	bool isUsed(uint16_t id) const;
+	uint32_t getNumFree() const;
+	//false once the id space is exhausted
+	bool allocate(uint8_t RadioID[2]);
+	bool allocate(uint16_t &id);
+	//stateless: maps index 0..ID_SPACE-3 onto the ids 0x0001..0xFFFE through the permutation (cycle walking),
+	//ignores the used bitmap
+	bool getIDForIndex(uint32_t index, uint16_t &id) const;
+	//inverse of the key file naming: first byte is 2 hex digits, second is unpadded
+	static bool parseKeyFileName(const char *name, uint16_t &id);
+protected:
+	uint16_t permute(uint16_t x) const;
+private:
+	uint32_t RoundKeys[FEISTEL_ROUNDS];
+	uint8_t Used[ID_SPACE / 8];
+	uint32_t NumUsed;
+	uint32_t Counter;
+};
+
+#endif
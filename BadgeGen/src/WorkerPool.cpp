@@ -0,0 +1,84 @@
+#include "WorkerPool.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+struct WorkerShared {
+	volatile uint32_t NextIndex;
+	uint32_t Count;
+	uint32_t ChunkSize;
+	WorkFunction Work;
+	void *Ctx;
+};
+
+struct WorkerArg {
+	WorkerShared *Shared;
+	uint32_t Worker;
+};
+
+static void *workerMain(void *p) {
+	WorkerArg *arg = (WorkerArg *) p;
+	WorkerShared *s = arg->Shared;
+	for (;;) {
+		uint32_t start = __sync_fetch_and_add(&s->NextIndex, s->ChunkSize);
+		if (start >= s->Count) {
+			break;
+		}
+		uint32_t end = start + s->ChunkSize;
+		if (end > s->Count || end < start) {
+			end = s->Count;
+		}
+		for (uint32_t i = start; i < end; i++) {
+			s->Work(i, arg->Worker, s->Ctx);
+		}
+	}
+	return 0;
+}
+
+WorkerPool::WorkerPool(uint32_t numThreads) :
+		NumThreads(numThreads == 0 ? getNumCores() : numThreads) {
+}
+
+uint32_t WorkerPool::getNumThreads() const {
+	return NumThreads;
+}
+
+uint32_t WorkerPool::getNumCores() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (uint32_t) n : 1;
+}
+
+void WorkerPool::run(uint32_t count, WorkFunction work, void *ctx, uint32_t chunkSize) {
+	if (count == 0) {
+		return;
+	}
+	WorkerShared shared;
+	shared.NextIndex = 0;
+	shared.Count = count;
+	shared.ChunkSize = chunkSize == 0 ? 1 : chunkSize;
+	shared.Work = work;
+	shared.Ctx = ctx;
+
+	uint32_t numThreads = NumThreads;
+	if (numThreads > (count + shared.ChunkSize - 1) / shared.ChunkSize) {
+		numThreads = (count + shared.ChunkSize - 1) / shared.ChunkSize;
+	}
+	std::vector<WorkerArg> args(numThreads);
+	std::vector<pthread_t> threads(numThreads);
+	uint32_t started = 0;
+	//worker 0 runs on the calling thread
+	for (uint32_t t = 1; t < numThreads; t++) {
+		args[t].Shared = &shared;
+		args[t].Worker = t;
+		if (pthread_create(&threads[t], 0, workerMain, &args[t]) != 0) {
+			break;
+		}
+		started = t;
+	}
+	args[0].Shared = &shared;
+	args[0].Worker = 0;
+	workerMain(&args[0]);
+	for (uint32_t t = 1; t <= started; t++) {
+		pthread_join(threads[t], 0);
+	}
+}
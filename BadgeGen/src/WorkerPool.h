@@ -0,0 +1,22 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+
+//called once per index, worker is 0..numThreads-1 so callers can keep per thread state
+typedef void (*WorkFunction)(uint32_t index, uint32_t worker, void *ctx);
+
+class WorkerPool {
+public:
+	//numThreads of 0 means one thread per online core
+	WorkerPool(uint32_t numThreads);
+	uint32_t getNumThreads() const;
+	//runs work for every index in [0,count), returns when all indexes are done
+	//indexes are handed out in small chunks from a shared counter so slow items don't stall a shard
+	void run(uint32_t count, WorkFunction work, void *ctx, uint32_t chunkSize = 16);
+	static uint32_t getNumCores();
+private:
+	uint32_t NumThreads;
+};
+
+#endif
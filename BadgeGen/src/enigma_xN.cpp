@@ -0,0 +1,40 @@
+#include "enigma_xN.h"
+#include <string.h>
+
+uint32_t enigma_letters(const char *ct, uint8_t *letters, uint32_t maxLetters) {
+	uint32_t n = 0;
+	for (; *ct != '\0' && n < maxLetters; ct++) {
+		if (*ct != ' ' && (*ct < '\t' || *ct > '\r')) {
+			letters[n++] = Enigma::letterIndex(*ct);
+		}
+	}
+	return n;
+}
+
+void enigma_crypt_x26(const Enigma &key, const uint8_t *ct, uint32_t len, uint8_t *plain) {
+	const uint32_t N = Enigma::NUM_LETTERS;
+	//column[x][p] = output for input x with the right rotor at p mod 26, doubled so a lane window never wraps
+	uint8_t column[N][2 * N];
+	bool built[N] = { false };
+	for (uint32_t i = 0; i < len; i++) {
+		uint8_t x = ct[i];
+		if (!built[x]) {
+			for (uint32_t p = 0; p < N; p++) {
+				column[x][p] = column[x][p + N] = key.step(p, x);
+			}
+			built[x] = true;
+		}
+	}
+	//the right rotor steps before each letter, so letter i sees start + i + 1
+	uint32_t row = 1;
+	for (uint32_t i = 0; i < len; i++) {
+		memcpy(plain + i * ENIGMA_XN_LANES, &column[ct[i]][row], ENIGMA_XN_LANES);
+		row = row == N - 1 ? 0 : row + 1;
+	}
+}
+
+void enigma_crypt_xN(const Enigma keys[], uint32_t count, const uint8_t *ct, uint32_t len, uint8_t *plain) {
+	for (uint32_t k = 0; k < count; k++) {
+		enigma_crypt_x26(keys[k], ct, len, plain + (size_t) k * len * ENIGMA_XN_LANES);
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef ENIGMA_XN_H
+#define ENIGMA_XN_H
+
+#include "enigma.h"
+
+//Trial decryption for the host tools: one ciphertext under every right rotor start position of a key at once.
+//Rotors, the other two positions and the plug board fix a 26x26 table of output letter by right rotor position
+//and input letter. Lane r (right rotor starting at r) reads its letter i from row (r + i + 1) mod 26 of the
+//column for ciphertext letter i, so all 26 lanes are one contiguous 26 byte slice of that column stored twice
+//over: no gathers and no per-lane arithmetic, plain vector loads at whatever width the compiler picks.
+//Worth it once a key is tried with several start positions or the ciphertext is longer than a few hundred letters.
+
+static const uint32_t ENIGMA_XN_LANES = Enigma::NUM_LETTERS;
+
+//ciphertext to letter indices (0-25) with whitespace dropped, returns how many were written
+uint32_t enigma_letters(const char *ct, uint8_t *letters, uint32_t maxLetters);
+
+//plain[i * ENIGMA_XN_LANES + r] = letter i (0-25) of ct decrypted under key with its right rotor starting at r,
+//the right start set in key is ignored. Matches Enigma::crypt for each lane.
+void enigma_crypt_x26(const Enigma &key, const uint8_t *ct, uint32_t len, uint8_t *plain);
+
+//enigma_crypt_x26 for count keys, key k's block starts at plain + k * len * ENIGMA_XN_LANES
+void enigma_crypt_xN(const Enigma keys[], uint32_t count, const uint8_t *ct, uint32_t len, uint8_t *plain);
+
+#endif
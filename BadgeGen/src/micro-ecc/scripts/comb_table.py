@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+
+# Generates comb-secp192r1.inc, the const fixed-base comb table used when uECC_COMB_CONST_TABLE
+# is enabled. Usage: comb_table.py [width] > comb-secp192r1.inc
+
+import sys
+
+width = 5
+if len(sys.argv) > 1:
+    width = int(sys.argv[1])
+
+p = 0xfffffffffffffffffffffffffffffffeffffffffffffffff
+n = 0xffffffffffffffffffffffff99def836146bc9b1b4d22831
+gx = 0x188da80eb03090f67cbf20eb43a18800f4ff0afd82ff1012
+gy = 0x07192b95ffc8da78631011ed6b24cdd573f977a11e794811
+num_n_bits = 192
+num_bytes = 24
+
+def inverse(a):
+    return pow(a, p - 2, p)
+
+def add(P, Q):
+    if P is None:
+        return Q
+    if Q is None:
+        return P
+    if P[0] == Q[0]:
+        if (P[1] + Q[1]) % p == 0:
+            return None
+        l = (3 * P[0] * P[0] - 3) * inverse(2 * P[1]) % p
+    else:
+        l = (Q[1] - P[1]) * inverse(Q[0] - P[0]) % p
+    x = (l * l - P[0] - Q[0]) % p
+    return (x, (l * (P[0] - x) - P[1]) % p)
+
+def mult(k, P):
+    R = None
+    while k:
+        if k & 1:
+            R = add(R, P)
+        P = add(P, P)
+        k >>= 1
+    return R
+
+def words(v):
+    b = ["%02X" % ((v >> (8 * i)) & 0xff) for i in range(num_bytes)]
+    return ["BYTES_TO_WORDS_8(%s)" % ", ".join(b[i:i + 8]) for i in range(0, num_bytes, 8)]
+
+d = (num_n_bits + width - 1) // width
+bases = [mult(1 << (i * d), (gx, gy)) for i in range(width)]
+
+print("/* Generated by scripts/comb_table.py %d, do not edit. */" % width)
+print("")
+print("#ifndef _UECC_COMB_SECP192R1_H_")
+print("#define _UECC_COMB_SECP192R1_H_")
+print("")
+print("#if uECC_COMB_WIDTH != %d" % width)
+print("    #error \"comb-secp192r1.inc was generated for a different uECC_COMB_WIDTH\"")
+print("#endif")
+print("")
+print("/* Entry j - 1 is the sum of 2^(i * %d) * G for every bit i set in j, then come" % d)
+print("   Q = 2^(%d * %d) * G and -2^%d * Q. */" % (width, d, d))
+print("static const uECC_word_t comb_secp192r1[((1 << %d) + 1) * 2 * num_words_secp192r1] = {" % width)
+entries = []
+for j in range(1, 1 << width):
+    P = None
+    for i in range(width):
+        if j & (1 << i):
+            P = add(P, bases[i])
+    entries.append(P)
+Q = mult(1 << (width * d), (gx, gy))
+C = mult(1 << d, Q)
+entries.append(Q)
+entries.append((C[0], (p - C[1]) % p))
+for j, P in enumerate(entries):
+    print("    " + ",\n    ".join(words(P[0]) + words(P[1])) + ("," if j < len(entries) - 1 else ""))
+print("};")
+print("")
+print("#endif /* _UECC_COMB_SECP192R1_H_ */")
@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+
+# Generates the fixed-size MULX/ADCX/ADOX multiplication used by asm_x86_64.inc.
+# Usage: mult_x86_64.py <size in 64-bit words>
+# Operand scanning: each row multiplies one word of left by all of right, with the low halves
+# going through the CF chain (adcx) and the high halves through the OF chain (adox).
+
+import sys
+
+if len(sys.argv) < 2:
+    print("Provide the integer size in 64-bit words")
+    sys.exit(1)
+
+size = int(sys.argv[1])
+
+def emit(line):
+    print('"' + line.replace("RDX", "%%rdx") + r' \n\t"')
+
+regs = ["%%[r%d]" % i for i in range(size + 1)]
+
+#### first row, plain add/adc is enough
+emit("movq 0(%[left]), RDX")
+emit("mulxq 0(%%[right]), %s, %s" % (regs[0], regs[1]))
+for j in range(1, size):
+    emit("mulxq %d(%%[right]), %%[t0], %s" % (j * 8, regs[j + 1]))
+    emit("%s %%[t0], %s" % ("addq" if j == 1 else "adcq", regs[j]))
+emit("adcq $0, %s" % regs[size])
+emit("movq %s, 0(%%[result])" % regs[0])
+
+window = regs[1:]
+free = regs[0]
+for i in range(1, size):
+    print("")
+    emit("movq %d(%%[left]), RDX" % (i * 8))
+    emit("xorl %k[zero], %k[zero]")
+    for j in range(size):
+        if j < size - 1:
+            emit("mulxq %d(%%[right]), %%[t0], %%[t1]" % (j * 8))
+            emit("adcxq %%[t0], %s" % window[j])
+            emit("adoxq %%[t1], %s" % window[j + 1])
+        else:
+            emit("mulxq %d(%%[right]), %%[t0], %s" % (j * 8, free))
+            emit("adcxq %%[t0], %s" % window[j])
+            emit("adoxq %%[zero], %s" % free)
+            emit("adcxq %%[zero], %s" % free)
+    emit("movq %s, %d(%%[result])" % (window[0], i * 8))
+    window, free = window[1:] + [free], window[0]
+
+print("")
+for k in range(size):
+    emit("movq %s, %d(%%[result])" % (window[k], (size + k) * 8))
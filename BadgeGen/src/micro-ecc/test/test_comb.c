@@ -0,0 +1,159 @@
+/* Copyright 2014, Kenneth MacKay. Licensed under the BSD 2-clause license. */
+
+#include "uECC.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_RANDOM 256
+#define MAX_SCALARS (NUM_RANDOM + 3 + 2 * 256)
+
+void vli_print(char *str, uint8_t *vli, unsigned int size) {
+    printf("%s ", str);
+    for(unsigned i=0; i<size; ++i) {
+        printf("%02X ", (unsigned)vli[i]);
+    }
+    printf("\n");
+}
+
+int main() {
+    int i;
+    int c;
+    int num_scalars;
+    int public_size;
+    int private_size;
+    int failed = 0;
+    uint8_t scalars[MAX_SCALARS][32];
+    uint8_t ladder_public[MAX_SCALARS][64];
+    int ladder_ok[MAX_SCALARS];
+    uint8_t public[64];
+    uint8_t g[64];
+    uint8_t x[32];
+    uint8_t hash[32] = {0};
+    uint8_t sig[64];
+    uint8_t batch_private[40 * 32];
+    uint8_t batch_public[40 * 64];
+
+    const struct uECC_Curve_t * curves[5];
+    int num_curves = 0;
+#if uECC_SUPPORTS_secp160r1
+    curves[num_curves++] = uECC_secp160r1();
+#endif
+#if uECC_SUPPORTS_secp192r1
+    curves[num_curves++] = uECC_secp192r1();
+#endif
+#if uECC_SUPPORTS_secp224r1
+    curves[num_curves++] = uECC_secp224r1();
+#endif
+#if uECC_SUPPORTS_secp256r1
+    curves[num_curves++] = uECC_secp256r1();
+#endif
+#if uECC_SUPPORTS_secp256k1
+    curves[num_curves++] = uECC_secp256k1();
+#endif
+
+    printf("Testing the fixed-base comb against the ladder\n");
+    for (c = 0; c < num_curves; ++c) {
+        public_size = uECC_curve_public_key_size(curves[c]);
+        private_size = uECC_curve_private_key_size(curves[c]);
+
+        /* 1, 2, 3, every power of two and 2^i - 1 below n, then random keys. The co-Z ladder
+           cannot do 1 * G (its last step hits the point at infinity), the comb can. */
+        num_scalars = 0;
+        memset(scalars, 0, sizeof(scalars));
+        for (i = 1; i <= 3; ++i) {
+            scalars[num_scalars++][private_size - 1] = i;
+        }
+        for (i = 2; i < (private_size - 1) * 8; ++i) {
+            scalars[num_scalars][private_size - 1 - i / 8] = 1 << (i % 8);
+            ++num_scalars;
+            memset(scalars[num_scalars], 0, private_size);
+            memset(scalars[num_scalars] + private_size - i / 8, 0xFF, i / 8);
+            scalars[num_scalars][private_size - 1 - i / 8] = (1 << (i % 8)) - 1;
+            ++num_scalars;
+        }
+        for (i = 0; i < NUM_RANDOM; ++i) {
+            if (!uECC_make_key(public, scalars[num_scalars], curves[c])) {
+                printf("uECC_make_key() failed\n");
+                return 1;
+            }
+            ++num_scalars;
+        }
+
+        /* Before uECC_precompute_comb() everything goes through the ladder. */
+        for (i = 0; i < num_scalars; ++i) {
+#if uECC_COMB_CONST_TABLE
+            ladder_ok[i] = 0;
+#else
+            ladder_ok[i] = uECC_compute_public_key(scalars[i], ladder_public[i], curves[c]);
+#endif
+        }
+        if (!uECC_precompute_comb(curves[c])) {
+            printf("No comb table for this curve, skipping\n");
+            continue;
+        }
+        /* G itself, for the x coordinate checks through uECC_shared_secret() */
+        if (!uECC_compute_public_key(scalars[0], g, curves[c]) ||
+            !uECC_valid_public_key(g, curves[c])) {
+            printf("Comb 1 * G failed\n");
+            return 1;
+        }
+
+        for (i = 0; i < num_scalars; ++i) {
+            printf(".");
+            fflush(stdout);
+
+            memset(public, 0, sizeof(public));
+            if (!uECC_compute_public_key(scalars[i], public, curves[c])) {
+                printf("uECC_compute_public_key() failed\n");
+                failed = 1;
+                continue;
+            }
+            if (ladder_ok[i] && memcmp(public, ladder_public[i], public_size) != 0) {
+                printf("Comb and ladder public keys are not identical!\n");
+                vli_print("Comb public key = ", public, public_size);
+                vli_print("Ladder public key = ", ladder_public[i], public_size);
+                vli_print("Private key = ", scalars[i], private_size);
+                failed = 1;
+            }
+            if (i > 0 && (!uECC_shared_secret(g, scalars[i], x, curves[c]) ||
+                          memcmp(public, x, public_size / 2) != 0)) {
+                printf("Comb public key does not match the ladder x coordinate!\n");
+                vli_print("Private key = ", scalars[i], private_size);
+                failed = 1;
+            }
+        }
+        printf("\n");
+
+        /* k * G when signing goes through the comb too, uECC_verify() does not */
+        for (i = 0; i < 64; ++i) {
+            hash[0] = i;
+            if (!uECC_sign(scalars[num_scalars - 1 - i % 8], hash, sizeof(hash), sig, curves[c])) {
+                printf("uECC_sign() failed\n");
+                failed = 1;
+                continue;
+            }
+            if (!uECC_compute_public_key(scalars[num_scalars - 1 - i % 8], public, curves[c]) ||
+                !uECC_verify(public, hash, sizeof(hash), sig, curves[c])) {
+                printf("uECC_verify() failed on a comb signature\n");
+                failed = 1;
+            }
+        }
+
+        /* and the batched key generation */
+        if (!uECC_make_keys_batch(40, batch_public, batch_private, curves[c])) {
+            printf("uECC_make_keys_batch() failed\n");
+            failed = 1;
+        }
+        for (i = 0; i < 40; ++i) {
+            if (!uECC_shared_secret(g, batch_private + i * private_size, x, curves[c]) ||
+                memcmp(batch_public + i * public_size, x, public_size / 2) != 0 ||
+                !uECC_valid_public_key(batch_public + i * public_size, curves[c])) {
+                printf("Batched comb public key does not match the ladder!\n");
+                failed = 1;
+            }
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,96 @@
+/* Copyright 2014, Kenneth MacKay. Licensed under the BSD 2-clause license. */
+
+#include "uECC.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_KEYS 100 /* deliberately not a multiple of uECC_BATCH_SIZE */
+
+void vli_print(char *str, uint8_t *vli, unsigned int size) {
+    printf("%s ", str);
+    for(unsigned i=0; i<size; ++i) {
+        printf("%02X ", (unsigned)vli[i]);
+    }
+    printf("\n");
+}
+
+int main() {
+    int i;
+    int c;
+    int public_size;
+    int private_size;
+    int failed = 0;
+    uint8_t private[NUM_KEYS * 32];
+    uint8_t public[NUM_KEYS * 64];
+    uint8_t private_single[32];
+    uint8_t public_computed[64];
+
+    const struct uECC_Curve_t * curves[5];
+    int num_curves = 0;
+#if uECC_SUPPORTS_secp160r1
+    curves[num_curves++] = uECC_secp160r1();
+#endif
+#if uECC_SUPPORTS_secp192r1
+    curves[num_curves++] = uECC_secp192r1();
+#endif
+#if uECC_SUPPORTS_secp224r1
+    curves[num_curves++] = uECC_secp224r1();
+#endif
+#if uECC_SUPPORTS_secp256r1
+    curves[num_curves++] = uECC_secp256r1();
+#endif
+#if uECC_SUPPORTS_secp256k1
+    curves[num_curves++] = uECC_secp256k1();
+#endif
+
+    printf("Testing %d batched key pairs against uECC_compute_public_key()\n", NUM_KEYS);
+    for (c = 0; c < num_curves; ++c) {
+        public_size = uECC_curve_public_key_size(curves[c]);
+        private_size = uECC_curve_private_key_size(curves[c]);
+
+        memset(public, 0, sizeof(public));
+        if (!uECC_make_keys_batch(NUM_KEYS, public, private, curves[c])) {
+            printf("uECC_make_keys_batch() failed\n");
+            return 1;
+        }
+
+        for (i = 0; i < NUM_KEYS; ++i) {
+            printf(".");
+            fflush(stdout);
+
+            /* keys are packed, give uECC_compute_public_key() one on its own */
+            memset(private_single, 0, sizeof(private_single));
+            memcpy(private_single, private + i * private_size, private_size);
+            memset(public_computed, 0, sizeof(public_computed));
+            if (!uECC_compute_public_key(private_single, public_computed, curves[c])) {
+                printf("uECC_compute_public_key() failed\n");
+                failed = 1;
+                continue;
+            }
+
+            if (memcmp(public + i * public_size, public_computed, public_size) != 0) {
+                printf("Batched and computed public keys are not identical!\n");
+                vli_print("Computed public key = ", public_computed, public_size);
+                vli_print("Batched public key = ", public + i * public_size, public_size);
+                vli_print("Private key = ", private + i * private_size, private_size);
+                failed = 1;
+            }
+        }
+        printf("\n");
+
+        /* a batch of one and an empty batch must work too */
+        if (!uECC_make_keys_batch(1, public, private, curves[c]) ||
+            !uECC_compute_public_key(private, public_computed, curves[c]) ||
+            memcmp(public, public_computed, public_size) != 0) {
+            printf("Single key batch failed\n");
+            failed = 1;
+        }
+        if (!uECC_make_keys_batch(0, public, private, curves[c])) {
+            printf("Empty batch failed\n");
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
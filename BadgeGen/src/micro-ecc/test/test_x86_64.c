@@ -0,0 +1,202 @@
+/* Copyright 2014, Kenneth MacKay. Licensed under the BSD 2-clause license. */
+
+/* Checks the x86-64 backend (asm_x86_64.inc) against plain C. Build with -DuECC_ENABLE_VLI_API=1;
+   build it again with -DuECC_X86_64_USE_ASM=0 to check the portable path the same way. */
+
+#include "uECC.h"
+#include "uECC_vli.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if uECC_WORD_SIZE == 8 && uECC_ENABLE_VLI_API
+
+#define NUM_TESTS 100000
+
+static uint64_t rng_state = 0x0123456789abcdefull;
+
+static uint64_t next_word(void) {
+    uint64_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    rng_state = x;
+    /* edge values turn up often, they are where carries go wrong */
+    switch (x & 15) {
+    case 0: return 0;
+    case 1: return ~0ull;
+    case 2: return ~0ull - 1;
+    case 3: return 1;
+    default: return x * 0x2545f4914f6cdd1dull;
+    }
+}
+
+static void ref_mult(uint64_t *result, const uint64_t *left, const uint64_t *right, int num_words) {
+    int i, j;
+    memset(result, 0, num_words * 2 * sizeof(uint64_t));
+    for (i = 0; i < num_words; ++i) {
+        unsigned __int128 carry = 0;
+        for (j = 0; j < num_words; ++j) {
+            carry += (unsigned __int128)left[i] * right[j] + result[i + j];
+            result[i + j] = (uint64_t)carry;
+            carry >>= 64;
+        }
+        result[i + num_words] = (uint64_t)carry;
+    }
+}
+
+/* result = product % mod, one bit at a time */
+static void ref_mod(uint64_t *result, const uint64_t *product, const uint64_t *mod, int num_words) {
+    uint64_t r[9] = {0};
+    int bit, i;
+    for (bit = num_words * 128 - 1; bit >= 0; --bit) {
+        uint64_t top = r[num_words - 1] >> 63;
+        uint64_t borrow = 0;
+        uint64_t t[8];
+        for (i = num_words - 1; i > 0; --i) {
+            r[i] = (r[i] << 1) | (r[i - 1] >> 63);
+        }
+        r[0] = (r[0] << 1) | ((product[bit / 64] >> (bit % 64)) & 1);
+        for (i = 0; i < num_words; ++i) {
+            unsigned __int128 d = (unsigned __int128)r[i] - mod[i] - borrow;
+            t[i] = (uint64_t)d;
+            borrow = (uint64_t)(d >> 64) & 1;
+        }
+        if (top || !borrow) {
+            memcpy(r, t, num_words * sizeof(uint64_t));
+        }
+    }
+    memcpy(result, r, num_words * sizeof(uint64_t));
+}
+
+void vli_print(char *str, const uint64_t *vli, int num_words) {
+    int i;
+    printf("%s ", str);
+    for (i = num_words - 1; i >= 0; --i) {
+        printf("%016llx ", (unsigned long long)vli[i]);
+    }
+    printf("\n");
+}
+
+int main() {
+    uint64_t a[8], b[8], r[16], expected[16];
+    int i, j, c, n;
+    int failed = 0;
+
+    const struct uECC_Curve_t * curves[5];
+    int num_curves = 0;
+#if uECC_SUPPORTS_secp160r1
+    curves[num_curves++] = uECC_secp160r1();
+#endif
+#if uECC_SUPPORTS_secp192r1
+    curves[num_curves++] = uECC_secp192r1();
+#endif
+#if uECC_SUPPORTS_secp224r1
+    curves[num_curves++] = uECC_secp224r1();
+#endif
+#if uECC_SUPPORTS_secp256r1
+    curves[num_curves++] = uECC_secp256r1();
+#endif
+#if uECC_SUPPORTS_secp256k1
+    curves[num_curves++] = uECC_secp256k1();
+#endif
+
+    printf("Testing add, sub, mult and square for 1 to 4 words\n");
+    for (n = 1; n <= 4; ++n) {
+        for (i = 0; i < NUM_TESTS && !failed; ++i) {
+            unsigned __int128 carry = 0;
+            uint64_t borrow = 0;
+            for (j = 0; j < n; ++j) {
+                a[j] = next_word();
+                b[j] = next_word();
+            }
+
+            for (j = 0; j < n; ++j) {
+                carry += (unsigned __int128)a[j] + b[j];
+                expected[j] = (uint64_t)carry;
+                carry >>= 64;
+            }
+            if (uECC_vli_add(r, a, b, n) != (uint64_t)carry || memcmp(r, expected, n * 8)) {
+                printf("uECC_vli_add() failed\n");
+                failed = 1;
+            }
+
+            for (j = 0; j < n; ++j) {
+                unsigned __int128 d = (unsigned __int128)a[j] - b[j] - borrow;
+                expected[j] = (uint64_t)d;
+                borrow = (uint64_t)(d >> 64) & 1;
+            }
+            if (uECC_vli_sub(r, a, b, n) != borrow || memcmp(r, expected, n * 8)) {
+                printf("uECC_vli_sub() failed\n");
+                failed = 1;
+            }
+
+            ref_mult(expected, a, b, n);
+            uECC_vli_mult(r, a, b, n);
+            if (memcmp(r, expected, n * 16)) {
+                printf("uECC_vli_mult() failed\n");
+                failed = 1;
+            }
+
+            ref_mult(expected, a, a, n);
+            uECC_vli_square(r, a, n);
+            if (memcmp(r, expected, n * 16)) {
+                printf("uECC_vli_square() failed\n");
+                failed = 1;
+            }
+
+            if (failed) {
+                vli_print("left  =", a, n);
+                vli_print("right =", b, n);
+            }
+        }
+    }
+
+    printf("Testing uECC_vli_modMult_fast() for each curve\n");
+    for (c = 0; c < num_curves && !failed; ++c) {
+        const uint64_t *p = uECC_curve_p(curves[c]);
+        n = (uECC_curve_public_key_size(curves[c]) / 2 + 7) / 8;
+        for (i = 0; i < NUM_TESTS && !failed; ++i) {
+            /* inputs below p, with values right under p mixed in */
+            for (j = 0; j < n; ++j) {
+                a[j] = next_word();
+                b[j] = (i & 7) ? next_word() : p[j];
+            }
+            if ((i & 7) == 0) {
+                b[0] -= 1 + (next_word() & 0xff);
+            }
+            if (uECC_vli_cmp(a, p, n) >= 0) {
+                uECC_vli_sub(a, a, p, n);
+            }
+            if (uECC_vli_cmp(b, p, n) >= 0) {
+                uECC_vli_sub(b, b, p, n);
+            }
+            if (uECC_vli_cmp(a, p, n) >= 0 || uECC_vli_cmp(b, p, n) >= 0) {
+                continue;
+            }
+
+            ref_mult(r, a, b, n);
+            ref_mod(expected, r, p, n);
+            uECC_vli_modMult_fast(r, a, b, curves[c]);
+            if (memcmp(r, expected, n * 8)) {
+                printf("uECC_vli_modMult_fast() failed\n");
+                vli_print("left     =", a, n);
+                vli_print("right    =", b, n);
+                vli_print("result   =", r, n);
+                vli_print("expected =", expected, n);
+                failed = 1;
+            }
+        }
+    }
+
+    return failed;
+}
+
+#else
+
+int main() {
+    printf("Needs uECC_WORD_SIZE == 8 and uECC_ENABLE_VLI_API\n");
+    return 0;
+}
+
+#endif
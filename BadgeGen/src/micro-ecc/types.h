@@ -33,6 +33,15 @@
     #endif
 #endif
 
+/* The x86-64 backend (asm_x86_64.inc) uses GCC-style inline assembly. */
+#ifndef uECC_X86_64_USE_ASM
+    #if (uECC_PLATFORM == uECC_x86_64) && defined(__GNUC__)
+        #define uECC_X86_64_USE_ASM 1
+    #else
+        #define uECC_X86_64_USE_ASM 0
+    #endif
+#endif
+
 #ifndef uECC_WORD_SIZE
     #if uECC_PLATFORM == uECC_avr
         #define uECC_WORD_SIZE 1
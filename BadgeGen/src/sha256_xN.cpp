@@ -0,0 +1,205 @@
+#include <string.h>
+#include "sha256_xN.h"
+
+//Same round structure as sha256.cpp, these work on one uint32 or on a GCC vector of them
+#define RotR(a,b) (((a) >> (b)) | ((a) << (32-(b))))
+#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+#define EP0(x) (RotR(x,2) ^ RotR(x,13) ^ RotR(x,22))
+#define EP1(x) (RotR(x,6) ^ RotR(x,11) ^ RotR(x,25))
+
+#define SIG0(x) (RotR(x,7) ^ RotR(x,18) ^ ((x) >> 3))
+#define SIG1(x) (RotR(x,17) ^ RotR(x,19) ^ ((x) >> 10))
+
+#define SCHEDULE(j) (w[(j)&15] += SIG1(w[((j)-2)&15]) + w[((j)-7)&15] + SIG0(w[((j)-15)&15]))
+#define MESSAGE(j) w[j]
+
+#define ROUND(a,b,c,d,e,f,g,h,j,wj) \
+	t1 = h + EP1(e) + CH(e,f,g) + k[j] + (wj); \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c)
+
+#define ROUNDS_8(j,W) \
+	ROUND(a,b,c,d,e,f,g,h,(j),W((j))); \
+	ROUND(h,a,b,c,d,e,f,g,(j)+1,W((j)+1)); \
+	ROUND(g,h,a,b,c,d,e,f,(j)+2,W((j)+2)); \
+	ROUND(f,g,h,a,b,c,d,e,(j)+3,W((j)+3)); \
+	ROUND(e,f,g,h,a,b,c,d,(j)+4,W((j)+4)); \
+	ROUND(d,e,f,g,h,a,b,c,(j)+5,W((j)+5)); \
+	ROUND(c,d,e,f,g,h,a,b,(j)+6,W((j)+6)); \
+	ROUND(b,c,d,e,f,g,h,a,(j)+7,W((j)+7))
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_XN_SIMD 1
+#else
+#define SHA256_XN_SIMD 0
+#endif
+
+#if SHA256_XN_SIMD
+
+static const uint32 k[64] = {
+	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+	0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+	0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+	0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+	0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+	0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+	0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+	0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
+
+static inline uint32 loadBE(const uchar *p) {
+	return ((uint32) p[0] << 24) | ((uint32) p[1] << 16) | ((uint32) p[2] << 8) | p[3];
+}
+
+static inline void storeBE(uchar *p, uint32 v) {
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+//blocks after padding: the 0x80 and 8 byte length need 9 bytes past the message
+static inline uint32 numBlocks(uint32 len) {
+	return (len + 8) / 64 + 1;
+}
+
+//Block blk of the padded message as 16 big endian words
+static void loadBlock(const uchar *msg, uint32 len, uint32 blk, uint32 w[16]) {
+	uint32 off = blk * 64;
+	if (off + 64 <= len) {
+		for (uint32 j = 0; j < 16; j++) {
+			w[j] = loadBE(msg + off + j * 4);
+		}
+		return;
+	}
+	uchar buf[64];
+	memset(&buf[0], 0, sizeof(buf));
+	if (off <= len) {
+		memcpy(&buf[0], msg + off, len - off);
+		buf[len - off] = 0x80;
+	}
+	if (blk == numBlocks(len) - 1) {
+		uint_64 bits = (uint_64) len * 8;
+		for (int n = 0; n < 8; n++) {
+			buf[63 - n] = bits >> n * 8;
+		}
+	}
+	for (uint32 j = 0; j < 16; j++) {
+		w[j] = loadBE(&buf[j * 4]);
+	}
+}
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#define XN_NAME sha256_x4
+#define XN_LANES 4
+#include "sha256_xN_lanes.inc"
+#undef XN_NAME
+#undef XN_LANES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define XN_NAME sha256_x8
+#define XN_LANES 8
+#include "sha256_xN_lanes.inc"
+#undef XN_NAME
+#undef XN_LANES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define XN_NAME sha256_x16
+#define XN_LANES 16
+#include "sha256_xN_lanes.inc"
+#undef XN_NAME
+#undef XN_LANES
+#pragma GCC pop_options
+
+typedef void (*LanesFunc)(const uchar *const msgs[], const uint32 lens[], uchar digests[][SHA256_XN_DIGEST_SIZE],
+		uint32 n);
+
+struct LaneImpl {
+	uint32 Lanes;
+	LanesFunc Func;
+	const char *Name;
+	const char *Feature;
+};
+
+//widest first
+static const LaneImpl IMPLS[] = {
+	{ 16, sha256_x16, "avx512", "avx512f" },
+	{ 8, sha256_x8, "avx2", "avx2" },
+	{ 4, sha256_x4, "sse2", "sse2" },
+};
+static const int NUM_IMPLS = sizeof(IMPLS) / sizeof(IMPLS[0]);
+
+static bool cpuSupports(const char *feature) {
+	//__builtin_cpu_supports only takes literals
+	if (strcmp(feature, "avx512f") == 0)
+		return __builtin_cpu_supports("avx512f");
+	if (strcmp(feature, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+	return __builtin_cpu_supports("sse2");
+}
+
+//index of the widest usable entry in IMPLS, NUM_IMPLS if none; worker threads may race here but all
+//compute the same answer
+static int firstImpl() {
+	static volatile int first = -1;
+	if (first < 0) {
+		__builtin_cpu_init();
+		int i = 0;
+		while (i < NUM_IMPLS && !cpuSupports(IMPLS[i].Feature)) {
+			i++;
+		}
+		first = i;
+	}
+	return first;
+}
+
+#endif
+
+static void digestScalar(const uchar *msg, uint32 len, uchar digest[SHA256_XN_DIGEST_SIZE]) {
+	ShaOBJ ctx;
+	sha256_init(&ctx);
+	sha256_add(&ctx, msg, len);
+	sha256_digest(&ctx, digest);
+}
+
+void sha256_digest_xN(const uchar *const msgs[], const uint32 lens[], uchar digests[][SHA256_XN_DIGEST_SIZE],
+		uint32 count) {
+	uint32 done = 0;
+#if SHA256_XN_SIMD
+	//full groups on the widest unit, what's left drops down to the narrower ones
+	for (int i = firstImpl(); i < NUM_IMPLS; i++) {
+		while (count - done >= IMPLS[i].Lanes) {
+			IMPLS[i].Func(&msgs[done], &lens[done], &digests[done], IMPLS[i].Lanes);
+			done += IMPLS[i].Lanes;
+		}
+	}
+#endif
+	for (; done < count; done++) {
+		digestScalar(msgs[done], lens[done], digests[done]);
+	}
+}
+
+uint32 sha256_xN_lanes() {
+#if SHA256_XN_SIMD
+	int i = firstImpl();
+	return i < NUM_IMPLS ? IMPLS[i].Lanes : 1;
+#else
+	return 1;
+#endif
+}
+
+const char *sha256_xN_impl() {
+#if SHA256_XN_SIMD
+	int i = firstImpl();
+	return i < NUM_IMPLS ? IMPLS[i].Name : "scalar";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,21 @@
+#ifndef SHA256_XN_H
+#define SHA256_XN_H
+
+#include "sha256.h"
+
+//Multi-buffer SHA-256 for the host tools: hashes many independent messages side by side, one per SIMD lane.
+//Picks AVX-512 (16 lanes), AVX2 (8) or SSE2 (4) at runtime and falls back to sha256.cpp elsewhere.
+//Best with short messages of similar length (registration codes, pairing hashes), a lane that finishes
+//early sits idle until the longest message in its group is done.
+
+static const uint32 SHA256_XN_DIGEST_SIZE = 32;
+
+//digests[i] = SHA256(msgs[i], lens[i]) for i < count, same results as sha256_init/add/digest
+void sha256_digest_xN(const uchar *const msgs[], const uint32 lens[], uchar digests[][SHA256_XN_DIGEST_SIZE],
+		uint32 count);
+
+//widest lane group sha256_digest_xN will use on this machine (1 = scalar) and its name for logs/bench output
+uint32 sha256_xN_lanes();
+const char *sha256_xN_impl();
+
+#endif
@@ -6,6 +6,12 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <getopt.h>
+#include "LoadTest.h"
+
+#define DEFAULT_HOST "54.174.215.133"
+#define DEFAULT_LOAD_HOST "127.0.0.1"
+#define DEFAULT_PORT 3456
 
 void error(const char *msg) {
 	perror(msg);
@@ -21,17 +27,24 @@ bool readAllData(int fd) {
 	return true;
 }
 
-int main(int argc, char *argv[]) {
-	int sockfd, portno, n;
+static void usage() {
+	printf("2016-client [-s host] [-p port]                    one interactive session, host defaults to %s\n",
+			DEFAULT_HOST);
+	printf("2016-client -n sessions [-c concurrent] [-x stages] [-P] [-t timeout ms] [-s host] [-p port]\n");
+	printf("            load test, host defaults to %s, %d stages initializes the daemon and stops it\n",
+			DEFAULT_LOAD_HOST, NUM_STAGES);
+}
+
+static int interactive(const char *host, int portno) {
+	int sockfd, n;
 	struct sockaddr_in serv_addr;
 	struct hostent *server;
 
 	char buffer[256];
-	portno = 3456;
 	sockfd = socket(AF_INET, SOCK_STREAM, 0);
 	if (sockfd < 0)
 		error("ERROR opening socket");
-	server = gethostbyname("54.174.215.133");
+	server = gethostbyname(host);
 	if (server == NULL) {
 		fprintf(stderr, "ERROR, no such host\n");
 		exit(0);
@@ -62,3 +75,54 @@ int main(int argc, char *argv[]) {
 	return 0;
 }
 
+int main(int argc, char *argv[]) {
+	LoadTestConfig config;
+	config.Host = 0;
+	config.Port = DEFAULT_PORT;
+	config.Sessions = 0;
+	config.Concurrency = 1000;
+	config.Stages = NUM_STAGES - 1;
+	config.Pipeline = false;
+	config.TimeoutMs = 10000;
+	int ch;
+	while ((ch = getopt(argc, argv, "s:p:n:c:x:Pt:")) != -1) {
+		switch (ch) {
+		case 's':
+			config.Host = optarg;
+			break;
+		case 'p':
+			config.Port = atoi(optarg);
+			break;
+		case 'n':
+			config.Sessions = strtoul(optarg, 0, 10);
+			break;
+		case 'c':
+			config.Concurrency = strtoul(optarg, 0, 10);
+			break;
+		case 'x':
+			config.Stages = strtoul(optarg, 0, 10);
+			break;
+		case 'P':
+			config.Pipeline = true;
+			break;
+		case 't':
+			config.TimeoutMs = strtoul(optarg, 0, 10);
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (config.Sessions == 0) {
+		return interactive(config.Host ? config.Host : DEFAULT_HOST, config.Port);
+	}
+	if (config.Concurrency == 0 || config.Stages == 0 || config.Stages > NUM_STAGES) {
+		usage();
+		return 1;
+	}
+	if (!config.Host) {
+		config.Host = DEFAULT_LOAD_HOST;
+	}
+	return runLoadTest(config);
+}
+
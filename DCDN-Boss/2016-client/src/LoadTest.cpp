@@ -0,0 +1,400 @@
+#include "LoadTest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <vector>
+
+static const char *ANSWERS[NUM_STAGES] = { "MONA\n", "XfjnhD0ZQ8\n", "5zQXLfSo71\n", "E2ElmnWDuv\n", "MY8VBVunA6\n",
+		"ZWxEcrPWc0\n", "4OmUw7DuEo\n" };
+//every reply but the last ends with the NUL of its noise block, the last is this
+static const char *INITIALIZED = "March Hare daemon initialized.\nConnection Terminated";
+static const int MAX_EVENTS = 256;
+static const int SWEEP_MS = 100;
+
+enum SessionError {
+	ERR_CONNECT, ERR_WRONG_ANSWER, ERR_CLOSED, ERR_IO, ERR_TIMEOUT, NUM_ERRORS
+};
+static const char *ERROR_NAMES[NUM_ERRORS] = { "connect failed", "wrong answer", "closed early", "socket error",
+		"timed out" };
+
+struct Session {
+	int FD;
+	bool Connected;
+	//answers queued so far and replies completed
+	uint32_t Sent;
+	uint32_t Replies;
+	bool AtReplyStart;
+	uint32_t FinalBytes;
+	uint64_t StartUs;
+	uint64_t SentUs[NUM_STAGES];
+	char Out[128];
+	uint32_t OutLength;
+	uint32_t OutSent;
+	//EPOLLOUT is in the registered events, true while connecting
+	bool WatchingOut;
+};
+
+static uint64_t monotonicUs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void raiseFileLimit() {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+}
+
+class LoadTest {
+public:
+	LoadTest(const LoadTestConfig &config) :
+			Config(config), EpollFD(-1), Started(0), Finished(0), Connects(0), Completed(0), Active() {
+		memset(&Addr, 0, sizeof(Addr));
+		memset(&Errors[0], 0, sizeof(Errors));
+	}
+	~LoadTest() {
+		if (EpollFD >= 0) {
+			close(EpollFD);
+		}
+	}
+	int run();
+private:
+	bool resolve();
+	void start();
+	void onEvent(Session *s, uint32_t events);
+	void onConnected(Session *s);
+	void queueAnswers(Session *s, uint32_t count);
+	void flush(Session *s);
+	void watchOut(Session *s, bool out);
+	void readReplies(Session *s);
+	void finish(Session *s, int error);
+	void sweep(uint64_t now);
+	void report(uint64_t elapsedUs);
+	static void printPercentiles(const char *name, std::vector<uint32_t> &samples);
+private:
+	LoadTestConfig Config;
+	sockaddr_in Addr;
+	int EpollFD;
+	uint32_t Started;
+	uint32_t Finished;
+	uint32_t Connects;
+	uint32_t Completed;
+	uint32_t Errors[NUM_ERRORS];
+	std::vector<Session *> Active;
+	//microseconds
+	std::vector<uint32_t> ConnectLatency;
+	std::vector<uint32_t> StageLatency[NUM_STAGES];
+	std::vector<uint32_t> SessionLatency;
+};
+
+bool LoadTest::resolve() {
+	addrinfo hints, *res = 0;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	int err = getaddrinfo(Config.Host, 0, &hints, &res);
+	if (err != 0 || !res) {
+		fprintf(stderr, "ERROR, no such host %s: %s\n", Config.Host, gai_strerror(err));
+		return false;
+	}
+	memcpy(&Addr, res->ai_addr, sizeof(Addr));
+	Addr.sin_port = htons(Config.Port);
+	freeaddrinfo(res);
+	return true;
+}
+
+void LoadTest::start() {
+	Started++;
+	Session *s = new Session;
+	memset(s, 0, sizeof(*s));
+	s->AtReplyStart = true;
+	s->WatchingOut = true;
+	s->StartUs = monotonicUs();
+	s->FD = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (s->FD < 0) {
+		perror("socket");
+		Errors[ERR_CONNECT]++;
+		Finished++;
+		delete s;
+		return;
+	}
+	if (connect(s->FD, (sockaddr *) &Addr, sizeof(Addr)) != 0 && errno != EINPROGRESS) {
+		Errors[ERR_CONNECT]++;
+		Finished++;
+		close(s->FD);
+		delete s;
+		return;
+	}
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+	ev.data.ptr = s;
+	epoll_ctl(EpollFD, EPOLL_CTL_ADD, s->FD, &ev);
+	Active.push_back(s);
+}
+
+void LoadTest::onConnected(Session *s) {
+	int err = 0;
+	socklen_t len = sizeof(err);
+	if (getsockopt(s->FD, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+		finish(s, ERR_CONNECT);
+		return;
+	}
+	s->Connected = true;
+	Connects++;
+	ConnectLatency.push_back((uint32_t) (monotonicUs() - s->StartUs));
+	queueAnswers(s, Config.Pipeline ? Config.Stages : 1);
+}
+
+//answers only go out when all before them are sent, so SentUs is when the last byte left
+void LoadTest::queueAnswers(Session *s, uint32_t count) {
+	uint64_t now = monotonicUs();
+	for (uint32_t i = 0; i < count && s->Sent < Config.Stages; i++) {
+		const char *a = ANSWERS[s->Sent];
+		uint32_t n = strlen(a);
+		if (s->OutLength + n > sizeof(s->Out)) {
+			break;
+		}
+		memcpy(&s->Out[s->OutLength], a, n);
+		s->OutLength += n;
+		s->SentUs[s->Sent++] = now;
+	}
+	flush(s);
+}
+
+void LoadTest::watchOut(Session *s, bool out) {
+	if (s->WatchingOut == out) {
+		return;
+	}
+	s->WatchingOut = out;
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP | (out ? (uint32_t) EPOLLOUT : 0u);
+	ev.data.ptr = s;
+	epoll_ctl(EpollFD, EPOLL_CTL_MOD, s->FD, &ev);
+}
+
+//level triggered, so EPOLLOUT is only asked for while something is left to send
+void LoadTest::flush(Session *s) {
+	if (s->OutLength == 0) {
+		return;
+	}
+	while (s->OutSent < s->OutLength) {
+		int n = send(s->FD, &s->Out[s->OutSent], s->OutLength - s->OutSent, MSG_NOSIGNAL);
+		if (n > 0) {
+			s->OutSent += n;
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+				finish(s, ERR_IO);
+			} else {
+				watchOut(s, true);
+			}
+			return;
+		}
+	}
+	s->OutLength = s->OutSent = 0;
+	watchOut(s, false);
+}
+
+void LoadTest::readReplies(Session *s) {
+	char buf[4096];
+	for (;;) {
+		int n = recv(s->FD, &buf[0], sizeof(buf), 0);
+		if (n == 0) {
+			finish(s, ERR_CLOSED);
+			return;
+		}
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				finish(s, ERR_IO);
+			}
+			return;
+		}
+		uint64_t now = monotonicUs();
+		for (int i = 0; i < n; i++) {
+			if (s->AtReplyStart) {
+				s->AtReplyStart = false;
+				if (buf[i] == 'I') {
+					finish(s, ERR_WRONG_ANSWER);
+					return;
+				}
+			}
+			bool done = false;
+			if (s->Replies == NUM_STAGES - 1) {
+				done = ++s->FinalBytes == strlen(INITIALIZED);
+			} else {
+				done = buf[i] == '\0';
+			}
+			if (!done) {
+				continue;
+			}
+			StageLatency[s->Replies].push_back((uint32_t) (now - s->SentUs[s->Replies]));
+			s->Replies++;
+			s->AtReplyStart = true;
+			if (s->Replies == Config.Stages) {
+				finish(s, -1);
+				return;
+			}
+			if (!Config.Pipeline) {
+				queueAnswers(s, 1);
+				if (s->FD < 0) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+void LoadTest::onEvent(Session *s, uint32_t events) {
+	if (!s->Connected) {
+		if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+			onConnected(s);
+		}
+		if (s->FD < 0 || !s->Connected) {
+			return;
+		}
+	} else if (events & EPOLLOUT) {
+		flush(s);
+	}
+	if (s->FD >= 0 && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+		readReplies(s);
+	}
+}
+
+//error -1 is a completed session. The Session is only marked here, sweep frees it so pending events stay valid
+void LoadTest::finish(Session *s, int error) {
+	if (s->FD < 0) {
+		return;
+	}
+	if (error < 0) {
+		Completed++;
+		SessionLatency.push_back((uint32_t) (monotonicUs() - s->StartUs));
+	} else {
+		Errors[error]++;
+	}
+	close(s->FD);
+	s->FD = -1;
+	Finished++;
+}
+
+void LoadTest::sweep(uint64_t now) {
+	uint64_t timeoutUs = (uint64_t) Config.TimeoutMs * 1000;
+	size_t kept = 0;
+	for (size_t i = 0; i < Active.size(); i++) {
+		Session *s = Active[i];
+		if (s->FD >= 0 && now - s->StartUs > timeoutUs) {
+			finish(s, ERR_TIMEOUT);
+		}
+		if (s->FD < 0) {
+			delete s;
+		} else {
+			Active[kept++] = s;
+		}
+	}
+	Active.resize(kept);
+	while (Started < Config.Sessions && Active.size() < Config.Concurrency) {
+		start();
+	}
+}
+
+int LoadTest::run() {
+	if (!resolve()) {
+		return 1;
+	}
+	raiseFileLimit();
+	EpollFD = epoll_create1(EPOLL_CLOEXEC);
+	if (EpollFD < 0) {
+		perror("epoll_create1");
+		return 1;
+	}
+	printf("%u sessions to %s:%d, %u at a time, %u stages%s\n", Config.Sessions, Config.Host, Config.Port,
+			Config.Concurrency, Config.Stages, Config.Pipeline ? ", pipelined" : "");
+	uint64_t begin = monotonicUs();
+	uint64_t nextSweep = begin;
+	epoll_event events[MAX_EVENTS];
+	while (Finished < Config.Sessions) {
+		uint64_t now = monotonicUs();
+		if (now >= nextSweep || Active.empty()) {
+			sweep(now);
+			nextSweep = now + SWEEP_MS * 1000;
+		}
+		int n = epoll_wait(EpollFD, &events[0], MAX_EVENTS, SWEEP_MS);
+		if (n < 0 && errno != EINTR) {
+			perror("epoll_wait");
+			return 1;
+		}
+		for (int i = 0; i < n; i++) {
+			Session *s = (Session *) events[i].data.ptr;
+			if (s->FD >= 0) {
+				onEvent(s, events[i].events);
+			}
+		}
+		//once an eighth of the slots have finished, refill them now rather than at the next sweep
+		if (Active.size() - (Started - Finished) > Active.size() / 8) {
+			sweep(monotonicUs());
+		}
+	}
+	sweep(monotonicUs());
+	report(monotonicUs() - begin);
+	uint32_t errors = 0;
+	for (int i = 0; i < NUM_ERRORS; i++) {
+		errors += Errors[i];
+	}
+	return errors == 0 ? 0 : 2;
+}
+
+void LoadTest::printPercentiles(const char *name, std::vector<uint32_t> &samples) {
+	if (samples.empty()) {
+		printf("  %-10s       -\n", name);
+		return;
+	}
+	std::sort(samples.begin(), samples.end());
+	size_t n = samples.size();
+	static const double P[3] = { 0.50, 0.99, 0.999 };
+	double ms[3];
+	for (int i = 0; i < 3; i++) {
+		size_t at = (size_t) (P[i] * n);
+		ms[i] = samples[at < n ? at : n - 1] / 1000.0;
+	}
+	printf("  %-10s %7lu %10.3f %10.3f %10.3f %10.3f\n", name, (unsigned long) n, ms[0], ms[1], ms[2],
+			samples[n - 1] / 1000.0);
+}
+
+void LoadTest::report(uint64_t elapsedUs) {
+	double secs = elapsedUs / 1e6;
+	printf("%.2f s: %u connects (%.0f/s), %u sessions completed (%.0f/s)\n", secs, Connects, Connects / secs,
+			Completed, Completed / secs);
+	printf("  %-10s %7s %10s %10s %10s %10s\n", "ms", "n", "p50", "p99", "p999", "max");
+	printPercentiles("connect", ConnectLatency);
+	for (uint32_t i = 0; i < Config.Stages; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "stage %u", i + 1);
+		printPercentiles(name, StageLatency[i]);
+	}
+	printPercentiles("session", SessionLatency);
+	for (int i = 0; i < NUM_ERRORS; i++) {
+		printf("%s: %u\n", ERROR_NAMES[i], Errors[i]);
+	}
+}
+
+int runLoadTest(const LoadTestConfig &config) {
+	LoadTest test(config);
+	return test.run();
+}
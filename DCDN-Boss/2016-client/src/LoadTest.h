@@ -0,0 +1,28 @@
+#ifndef LOAD_TEST_H
+#define LOAD_TEST_H
+
+#include <stdint.h>
+
+//answers the daemon expects, in order
+#define NUM_STAGES 7
+
+struct LoadTestConfig {
+	const char *Host;
+	int Port;
+	//sessions to run in total
+	uint32_t Sessions;
+	//sessions open at once
+	uint32_t Concurrency;
+	//answers per session, NUM_STAGES initializes the daemon and shuts it down so the default stops one short
+	uint32_t Stages;
+	//send every answer up front instead of one per reply
+	bool Pipeline;
+	//a session that hasn't finished by then counts as a timeout
+	uint32_t TimeoutMs;
+};
+
+//Runs Sessions scripted sessions against the daemon from one epoll loop and prints connection rate, session
+//throughput, per stage latency percentiles and error counts. Returns the process exit code.
+int runLoadTest(const LoadTestConfig &config);
+
+#endif
@@ -0,0 +1,143 @@
+#include "AsyncLog.h"
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+static const char *EVENT_FORMATS[NUM_LOG_EVENTS] = { "server: got connection from %s", "server full, refusing %s",
+		"Wrong answer sent by connection: %s", "%s too much time between data", "%s was connected for too long",
+		"dropping connection %s" };
+
+LogRing::LogRing() :
+		Head(0), Tail(0), Dropped(0) {
+	memset(&Pad[0], 0, sizeof(Pad));
+}
+
+void LogRing::push(uint64_t timeMs, LogEvent event, const in_addr &addr, int fd) {
+	uint32_t tail = Tail;
+	if (tail - __atomic_load_n(&Head, __ATOMIC_ACQUIRE) == SIZE) {
+		__atomic_fetch_add(&Dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	LogRecord &r = Records[tail & (SIZE - 1)];
+	r.TimeMs = timeMs;
+	r.Addr = addr.s_addr;
+	r.FD = fd;
+	r.Event = event;
+	__atomic_store_n(&Tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t LogRing::pop(LogRecord *out, uint32_t max) {
+	uint32_t head = Head;
+	uint32_t n = __atomic_load_n(&Tail, __ATOMIC_ACQUIRE) - head;
+	if (n > max) {
+		n = max;
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		out[i] = Records[(head + i) & (SIZE - 1)];
+	}
+	__atomic_store_n(&Head, head + n, __ATOMIC_RELEASE);
+	return n;
+}
+
+uint32_t LogRing::takeDropped() {
+	return __atomic_exchange_n(&Dropped, 0, __ATOMIC_RELAXED);
+}
+
+AsyncLog::AsyncLog(FILE *out) :
+		Out(out), Rings(), Writer(), Started(false), KeepRunning(true), WallOffsetMs(0), BufferLength(0) {
+	timespec mono, wall;
+	clock_gettime(CLOCK_MONOTONIC, &mono);
+	clock_gettime(CLOCK_REALTIME, &wall);
+	WallOffsetMs = ((int64_t) wall.tv_sec - mono.tv_sec) * 1000 + (wall.tv_nsec - mono.tv_nsec) / 1000000;
+}
+
+AsyncLog::~AsyncLog() {
+	stop();
+	for (size_t i = 0; i < Rings.size(); i++) {
+		delete Rings[i];
+	}
+}
+
+LogRing *AsyncLog::createRing() {
+	LogRing *ring = new LogRing();
+	Rings.push_back(ring);
+	return ring;
+}
+
+bool AsyncLog::start() {
+	if (pthread_create(&Writer, 0, writerMain, this) != 0) {
+		perror("pthread_create log writer");
+		return false;
+	}
+	Started = true;
+	return true;
+}
+
+void AsyncLog::stop() {
+	if (Started) {
+		__atomic_store_n(&KeepRunning, false, __ATOMIC_RELEASE);
+		pthread_join(Writer, 0);
+		Started = false;
+	}
+	drain();
+}
+
+void *AsyncLog::writerMain(void *p) {
+	AsyncLog *log = (AsyncLog *) p;
+	while (__atomic_load_n(&log->KeepRunning, __ATOMIC_ACQUIRE)) {
+		log->drain();
+		usleep(FLUSH_MS * 1000);
+	}
+	return 0;
+}
+
+//a line is well under 128 bytes
+void AsyncLog::makeRoom() {
+	if (BufferLength + 128 > sizeof(Buffer)) {
+		fwrite(&Buffer[0], 1, BufferLength, Out);
+		BufferLength = 0;
+	}
+}
+
+void AsyncLog::write(uint32_t ring, const LogRecord &r) {
+	makeRoom();
+	int64_t wallMs = (int64_t) r.TimeMs + WallOffsetMs;
+	time_t secs = wallMs / 1000;
+	tm t;
+	localtime_r(&secs, &t);
+	in_addr addr;
+	addr.s_addr = r.Addr;
+	char ip[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &addr, &ip[0], sizeof(ip));
+	char *p = &Buffer[BufferLength];
+	size_t room = sizeof(Buffer) - BufferLength;
+	int n = snprintf(p, room, "%02d:%02d:%02d.%03d w%u fd %d: ", t.tm_hour, t.tm_min, t.tm_sec, (int) (wallMs % 1000),
+			ring, r.FD);
+	n += snprintf(p + n, room - n, EVENT_FORMATS[r.Event], &ip[0]);
+	p[n++] = '\n';
+	BufferLength += n;
+}
+
+void AsyncLog::drain() {
+	LogRecord batch[BATCH];
+	for (uint32_t i = 0; i < Rings.size(); i++) {
+		uint32_t dropped = Rings[i]->takeDropped();
+		if (dropped) {
+			makeRoom();
+			BufferLength += snprintf(&Buffer[BufferLength], sizeof(Buffer) - BufferLength,
+					"w%u: log ring full, %u records dropped\n", i, dropped);
+		}
+		uint32_t n;
+		while ((n = Rings[i]->pop(&batch[0], BATCH)) > 0) {
+			for (uint32_t j = 0; j < n; j++) {
+				write(i, batch[j]);
+			}
+		}
+	}
+	if (BufferLength > 0) {
+		fwrite(&Buffer[0], 1, BufferLength, Out);
+		BufferLength = 0;
+		fflush(Out);
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <vector>
+
+enum LogEvent {
+	LOG_CONNECTED, LOG_SERVER_FULL, LOG_WRONG_ANSWER, LOG_IDLE_TIMEOUT, LOG_CONNECTION_TIMEOUT, LOG_DROPPED, NUM_LOG_EVENTS
+};
+
+struct LogRecord {
+	//monotonic ms, the writer turns it into wall clock time
+	uint64_t TimeMs;
+	//network byte order
+	uint32_t Addr;
+	int32_t FD;
+	uint32_t Event;
+};
+
+//Single producer, single consumer ring of LogRecords, one per worker thread. The worker only ever writes Tail and
+//the writer only ever writes Head, so push is a handful of plain stores and one release store. When the writer
+//falls behind records are counted and dropped rather than stalling the worker.
+class LogRing {
+public:
+	static const uint32_t SIZE = 8192;
+public:
+	LogRing();
+	void push(uint64_t timeMs, LogEvent event, const in_addr &addr, int fd);
+	//writer side, copies up to max records out and frees their slots
+	uint32_t pop(LogRecord *out, uint32_t max);
+	//writer side, records dropped since the last call
+	uint32_t takeDropped();
+private:
+	LogRing(const LogRing &);
+	LogRing &operator=(const LogRing &);
+private:
+	uint32_t Head;
+	//keeps Head and Tail, written by different threads, on different cache lines
+	char Pad[60];
+	uint32_t Tail;
+	uint32_t Dropped;
+	LogRecord Records[SIZE];
+};
+
+//Owns the rings and the thread that formats and writes them out in batches every FLUSH_MS.
+class AsyncLog {
+public:
+	static const int FLUSH_MS = 50;
+	static const uint32_t BATCH = 256;
+public:
+	AsyncLog(FILE *out);
+	~AsyncLog();
+	//all rings before start, they live until the log is destroyed
+	LogRing *createRing();
+	bool start();
+	//writes out whatever is left and joins the writer
+	void stop();
+private:
+	AsyncLog(const AsyncLog &);
+	AsyncLog &operator=(const AsyncLog &);
+	static void *writerMain(void *p);
+	void drain();
+	void makeRoom();
+	void write(uint32_t ring, const LogRecord &r);
+private:
+	FILE *Out;
+	std::vector<LogRing *> Rings;
+	pthread_t Writer;
+	bool Started;
+	bool KeepRunning;
+	//added to a record's monotonic ms to get ms since the epoch
+	int64_t WallOffsetMs;
+	char Buffer[65536];
+	uint32_t BufferLength;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "ClientInfo.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ClientInfo::ClientInfo() :
+		FD(-1), Addr(), RightAnswers(0), AnswerPos(0), ConnectTime(0), LastDataReceived(0), ConnectTimeUs(0),
+		StageStart(0), Input(), Output(), FirstOutSegment(0), NumOutSegments(0), Dead(false), PeerClosed(false),
+		Timer(this), PoolPrev(0), PoolNext(0) {
+}
+
+ClientInfo::~ClientInfo() {
+	close();
+}
+
+void ClientInfo::open(int fd, const in_addr &addr, uint64_t now, uint64_t nowUs) {
+	FD = fd;
+	Addr = addr;
+	RightAnswers = 0;
+	AnswerPos = 0;
+	ConnectTime = LastDataReceived = now;
+	ConnectTimeUs = StageStart = nowUs;
+	Input.clear();
+	Output.clear();
+	FirstOutSegment = NumOutSegments = 0;
+	Dead = false;
+	PeerClosed = false;
+}
+
+void ClientInfo::close() {
+	if (FD >= 0) {
+		::close(FD);
+		FD = -1;
+	}
+}
+
+bool ClientInfo::bufferIn(uint64_t now, uint64_t &received) {
+	for (;;) {
+		iovec iov[2];
+		int num = Input.getFree(iov);
+		if (num == 0) {
+			return true;
+		}
+		ssize_t n = readv(FD, &iov[0], num);
+		if (n > 0) {
+			Input.commit(n);
+			LastDataReceived = now;
+			received += n;
+		} else {
+			if (n == 0) {
+				PeerClosed = true;
+			} else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				Dead = true;
+			}
+			if (n == 0 || errno != EINTR) {
+				return false;
+			}
+		}
+	}
+}
+
+void ClientInfo::bufferIn(const char *b, uint32_t n, uint64_t now) {
+	iovec iov[2];
+	Input.append(b, n, iov);
+	LastDataReceived = now;
+}
+
+void ClientInfo::queueOut(void *b, size_t n) {
+	if (NumOutSegments > 0) {
+		iovec &last = OutSegments[(FirstOutSegment + NumOutSegments - 1) & (MAX_OUT_SEGMENTS - 1)];
+		//consecutive copies into the ring go out as one
+		if (Output.contains(b) && (char *) last.iov_base + last.iov_len == b) {
+			last.iov_len += n;
+			return;
+		}
+	}
+	if (NumOutSegments == MAX_OUT_SEGMENTS) {
+		Dead = true;
+		return;
+	}
+	iovec &seg = OutSegments[(FirstOutSegment + NumOutSegments) & (MAX_OUT_SEGMENTS - 1)];
+	seg.iov_base = b;
+	seg.iov_len = n;
+	NumOutSegments++;
+}
+
+void ClientInfo::bufferOut(const char *b, int n) {
+	iovec iov[2];
+	int num = Output.append(b, n, iov);
+	if (num == 0 && n > 0) {
+		Dead = true;
+	}
+	for (int i = 0; i < num; i++) {
+		queueOut(iov[i].iov_base, iov[i].iov_len);
+	}
+}
+
+void ClientInfo::bufferOutStatic(const char *b, int n) {
+	if (n > 0) {
+		queueOut((void *) b, n);
+	}
+}
+
+void ClientInfo::popSent(size_t n) {
+	while (n > 0) {
+		iovec &seg = OutSegments[FirstOutSegment];
+		size_t take = n < seg.iov_len ? n : seg.iov_len;
+		if (Output.contains(seg.iov_base)) {
+			Output.consume(take);
+		}
+		seg.iov_base = (char *) seg.iov_base + take;
+		seg.iov_len -= take;
+		n -= take;
+		if (seg.iov_len == 0) {
+			FirstOutSegment = (FirstOutSegment + 1) & (MAX_OUT_SEGMENTS - 1);
+			NumOutSegments--;
+		}
+	}
+}
+
+size_t ClientInfo::sendAll() {
+	size_t total = 0;
+	while (NumOutSegments > 0) {
+		iovec iov[MAX_OUT_SEGMENTS];
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov[0];
+		msg.msg_iovlen = getOutput(&iov[0]);
+		ssize_t n = sendmsg(FD, &msg, MSG_NOSIGNAL);
+		if (n > 0) {
+			popSent(n);
+			total += n;
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+				Dead = true;
+			}
+			break;
+		}
+	}
+	return total;
+}
+
+uint32_t ClientInfo::getOutput(iovec *iov) const {
+	for (uint32_t i = 0; i < NumOutSegments; i++) {
+		iov[i] = OutSegments[(FirstOutSegment + i) & (MAX_OUT_SEGMENTS - 1)];
+	}
+	return NumOutSegments;
+}
+
+uint64_t ClientInfo::getDeadline(uint64_t maxBetweenData, uint64_t maxForConnection) const {
+	uint64_t idle = LastDataReceived + maxBetweenData + 1;
+	uint64_t total = ConnectTime + maxForConnection + 1;
+	return idle < total ? idle : total;
+}
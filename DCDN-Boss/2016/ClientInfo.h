@@ -0,0 +1,77 @@
+#ifndef CLIENT_INFO_H
+#define CLIENT_INFO_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include <sys/uio.h>
+#include "RingBuffer.h"
+#include "TimerWheel.h"
+
+//one puzzle session. With the epoll backend the socket is non-blocking and registered edge triggered so every
+//read and write keeps going until EAGAIN or the next event never comes, the io_uring backend does its own reads
+//and sends and only uses the buffers.
+//Input is read straight into a ring, output is a queue of iovecs pointing either into the output ring or at
+//static text, sent with one sendmsg, so a message costs no heap allocation and no concatenation.
+//Slots live in a ClientPool and are reused, open() starts a session in one and close() ends it.
+struct ClientInfo {
+	static const uint32_t INPUT_SIZE = 512;
+	static const uint32_t OUTPUT_SIZE = 2048;
+	//power of two, a full session queues about 20
+	static const uint32_t MAX_OUT_SEGMENTS = 32;
+
+	int FD;
+	in_addr Addr;
+	int RightAnswers;
+	//bytes of the current answer matched so far
+	int AnswerPos;
+	//ms on the server's monotonic clock
+	uint64_t ConnectTime;
+	uint64_t LastDataReceived;
+	//us on the same clock, for the latency histograms. StageStart is the connect, or the last right answer
+	uint64_t ConnectTimeUs;
+	uint64_t StageStart;
+	RingBuffer<INPUT_SIZE> Input;
+	RingBuffer<OUTPUT_SIZE> Output;
+	iovec OutSegments[MAX_OUT_SEGMENTS];
+	uint32_t FirstOutSegment;
+	uint32_t NumOutSegments;
+	bool Dead;
+	//the client shut down its side, Dead once handleInput has answered what it sent before that
+	bool PeerClosed;
+	//armed for getDeadline in the server's timer wheel
+	TimerNode Timer;
+	//ClientPool's active list, or its free list through PoolNext
+	ClientInfo *PoolPrev;
+	ClientInfo *PoolNext;
+
+	ClientInfo();
+	~ClientInfo();
+	void open(int fd, const in_addr &addr, uint64_t now, uint64_t nowUs);
+	void close();
+	//reads until EAGAIN, PeerClosed on EOF, Dead on error, adding what came in to received. True if it stopped because Input
+	//is full and there may be more
+	bool bufferIn(uint64_t now, uint64_t &received);
+	//copies b into Output, Dead if the client has let it fill up
+	void bufferOut(const char *b, int n);
+	//queues b itself, it has to outlive the session (string literals, static tables)
+	void bufferOutStatic(const char *b, int n);
+	//copies n bytes someone else read into Input, they have to fit
+	void bufferIn(const char *b, uint32_t n, uint64_t now);
+	//sends until the buffer is empty or the socket is full, Dead on error. Returns the bytes sent
+	size_t sendAll();
+	//for sending it some other way: the queued output as iovecs (at most MAX_OUT_SEGMENTS), and dropping the
+	//first n bytes once they are gone
+	uint32_t getOutput(iovec *iov) const;
+	void popSent(size_t n);
+	bool hasOutput() const {
+		return NumOutSegments > 0;
+	}
+	//first ms at which the timeouts in Server.cpp drop this session
+	uint64_t getDeadline(uint64_t maxBetweenData, uint64_t maxForConnection) const;
+private:
+	ClientInfo(const ClientInfo &);
+	ClientInfo &operator=(const ClientInfo &);
+	void queueOut(void *b, size_t n);
+};
+
+#endif
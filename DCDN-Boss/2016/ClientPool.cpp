@@ -0,0 +1,63 @@
+#include "ClientPool.h"
+#include <new>
+
+ClientPool::ClientPool() :
+		Slab(0), Capacity(0), FreeList(0), Active(0) {
+}
+
+ClientPool::~ClientPool() {
+	//closes whatever is still connected
+	delete[] Slab;
+}
+
+bool ClientPool::init(uint32_t capacity) {
+	Slab = new (std::nothrow) ClientInfo[capacity];
+	if (!Slab) {
+		return false;
+	}
+	Capacity = capacity;
+	//lowest slots first, keeps a quiet server's sessions on few pages
+	for (uint32_t i = capacity; i > 0; i--) {
+		Slab[i - 1].PoolNext = FreeList;
+		FreeList = &Slab[i - 1];
+	}
+	return true;
+}
+
+ClientInfo *ClientPool::acquire() {
+	ClientInfo *c = FreeList;
+	if (!c) {
+		return 0;
+	}
+	FreeList = c->PoolNext;
+	c->PoolPrev = 0;
+	c->PoolNext = Active;
+	if (Active) {
+		Active->PoolPrev = c;
+	}
+	Active = c;
+	return c;
+}
+
+void ClientPool::release(ClientInfo *c) {
+	c->close();
+	if (c->PoolPrev) {
+		c->PoolPrev->PoolNext = c->PoolNext;
+	} else {
+		Active = c->PoolNext;
+	}
+	if (c->PoolNext) {
+		c->PoolNext->PoolPrev = c->PoolPrev;
+	}
+	c->PoolPrev = 0;
+	c->PoolNext = FreeList;
+	FreeList = c;
+}
+
+uint32_t ClientPool::getCapacity() const {
+	return Capacity;
+}
+
+size_t ClientPool::getBytesPerClient() {
+	return sizeof(ClientInfo);
+}
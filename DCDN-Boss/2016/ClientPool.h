@@ -0,0 +1,40 @@
+#ifndef CLIENT_POOL_H
+#define CLIENT_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ClientInfo.h"
+
+//Every session slot a Server will ever use, allocated once up front. Free slots are a singly linked list and
+//sessions in use a doubly linked one, both threaded through the slots themselves, so accepting and dropping a
+//connection are a couple of pointer swaps and never touch the heap.
+class ClientPool {
+public:
+	ClientPool();
+	~ClientPool();
+	//false if the slab can't be allocated
+	bool init(uint32_t capacity);
+	//a free slot moved to the active list, 0 when all are in use
+	ClientInfo *acquire();
+	//closes the session and returns its slot
+	void release(ClientInfo *c);
+	//slots are numbered 0 to capacity - 1, for keeping something alongside each in a plain array
+	uint32_t getIndex(const ClientInfo *c) const {
+		return (uint32_t) (c - Slab);
+	}
+	ClientInfo *getSlot(uint32_t index) const {
+		return &Slab[index];
+	}
+	uint32_t getCapacity() const;
+	static size_t getBytesPerClient();
+private:
+	ClientPool(const ClientPool &);
+	ClientPool &operator=(const ClientPool &);
+private:
+	ClientInfo *Slab;
+	uint32_t Capacity;
+	ClientInfo *FreeList;
+	ClientInfo *Active;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "EpollServer.h"
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+//epoll data.ptr of the shutdown eventfd, 0 is the listen socket and everything else is a ClientInfo
+static char SHUTDOWN_TAG;
+
+EpollServer::EpollServer(int listenFD, int shutdownFD, uint32_t maxClients, LogRing *log, WorkerMetrics *metrics) :
+		Server(listenFD, shutdownFD, maxClients, log, metrics), EpollFD(-1), AcceptPaused(false) {
+}
+
+EpollServer::~EpollServer() {
+	if (EpollFD >= 0) {
+		close(EpollFD);
+	}
+}
+
+bool EpollServer::init() {
+	if (!Server::init()) {
+		return false;
+	}
+	EpollFD = epoll_create1(EPOLL_CLOEXEC);
+	if (EpollFD < 0) {
+		perror("epoll_create1");
+		return false;
+	}
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.ptr = 0;
+	if (epoll_ctl(EpollFD, EPOLL_CTL_ADD, ListenFD, &ev) != 0) {
+		perror("epoll_ctl listen");
+		return false;
+	}
+	//level triggered and never read, so it stays readable for every worker
+	ev.events = EPOLLIN;
+	ev.data.ptr = &SHUTDOWN_TAG;
+	if (epoll_ctl(EpollFD, EPOLL_CTL_ADD, ShutdownFD, &ev) != 0) {
+		perror("epoll_ctl shutdown");
+		return false;
+	}
+	return true;
+}
+
+void EpollServer::acceptAll() {
+	for (;;) {
+		sockaddr_in their_addr;
+		socklen_t sin_size = sizeof(their_addr);
+		int new_fd = accept4(ListenFD, (sockaddr *) &their_addr, &sin_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (new_fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			//out of descriptors leaves the queue full and edge triggered won't say so again, poll it for a bit
+			AcceptPaused = errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM;
+			if (AcceptPaused) {
+				perror("accept4");
+			}
+			return;
+		}
+		ClientInfo *c = openSession(new_fd, their_addr.sin_addr);
+		if (!c) {
+			continue;
+		}
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		ev.data.ptr = c;
+		if (epoll_ctl(EpollFD, EPOLL_CTL_ADD, new_fd, &ev) != 0) {
+			perror("epoll_ctl client");
+			drop(c);
+		}
+	}
+}
+
+void EpollServer::onClient(ClientInfo *c, uint32_t events) {
+	if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+		//a full ring stops the read early, edge triggered won't report the rest so go back for it
+		bool more;
+		uint64_t received = 0;
+		do {
+			more = c->bufferIn(Now, received);
+			handleInput(c);
+		} while (more && !c->Dead && !c->Input.isFull());
+		bumpCounter(Stats->BytesIn, received);
+	}
+	//EPOLLOUT only matters when output is waiting, sendAll is a no-op otherwise
+	size_t sent = c->sendAll();
+	if (sent) {
+		bumpCounter(Stats->BytesOut, sent);
+	}
+	if (c->Dead) {
+		drop(c);
+	} else {
+		armTimeout(c);
+	}
+}
+
+void EpollServer::drop(ClientInfo *c) {
+	endSession(c);
+	//closing the fd takes it out of the epoll set
+	Clients.release(c);
+}
+
+int EpollServer::getWaitMs() const {
+	return AcceptPaused ? ACCEPT_RETRY_MS : getTimeout();
+}
+
+void EpollServer::run() {
+	epoll_event events[MAX_EVENTS];
+	while (KeepRunning) {
+		if (AcceptPaused) {
+			acceptAll();
+		}
+		//noise used by the last batch is made up while nothing is waiting on it
+		Noise.refill();
+		int n = epoll_wait(EpollFD, &events[0], MAX_EVENTS, getWaitMs());
+		updateNow();
+		if (n < 0 && errno != EINTR) {
+			perror("epoll_wait");
+			return;
+		}
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.ptr == 0) {
+				acceptAll();
+			} else if (events[i].data.ptr == &SHUTDOWN_TAG) {
+				KeepRunning = false;
+			} else {
+				onClient((ClientInfo *) events[i].data.ptr, events[i].events);
+			}
+		}
+		runTimeouts();
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef EPOLL_SERVER_H
+#define EPOLL_SERVER_H
+
+#include "Server.h"
+
+//Edge triggered epoll backend.
+//Only sockets with something to do are touched: the listen socket's accept queue is drained with accept4
+//until EAGAIN, a client is read until EAGAIN when it is readable and flushed when it has output and the
+//socket takes it. Between events the loop sleeps in epoll_wait until the next timeout is due.
+class EpollServer: public Server {
+public:
+	static const int MAX_EVENTS = 256;
+public:
+	EpollServer(int listenFD, int shutdownFD, uint32_t maxClients, LogRing *log, WorkerMetrics *metrics);
+	virtual ~EpollServer();
+	virtual bool init();
+	virtual void run();
+protected:
+	virtual void drop(ClientInfo *c);
+private:
+	void acceptAll();
+	void onClient(ClientInfo *c, uint32_t events);
+	int getWaitMs() const;
+private:
+	int EpollFD;
+	bool AcceptPaused;
+};
+
+#endif
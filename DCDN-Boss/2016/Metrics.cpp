@@ -0,0 +1,254 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+Histogram::Histogram() :
+		Sum(0), Count(0) {
+	memset(&Counts[0], 0, sizeof(Counts));
+}
+
+void Histogram::add(const Histogram &other) {
+	for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+		Counts[i] += readCounter(other.Counts[i]);
+	}
+	Sum += readCounter(other.Sum);
+	Count += readCounter(other.Count);
+}
+
+uint64_t Histogram::getBucketMax(uint32_t bucket) {
+	if (bucket < 2 * SUB_BUCKETS) {
+		return bucket;
+	}
+	uint32_t shift = bucket / SUB_BUCKETS - 1;
+	uint64_t min = (uint64_t) (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+	return min + ((uint64_t) 1 << shift) - 1;
+}
+
+WorkerMetrics::WorkerMetrics() :
+		Accepts(0), Refused(0), Closed(0), WrongAnswers(0), IdleTimeouts(0), ConnectionTimeouts(0), BytesIn(0),
+		BytesOut(0) {
+	memset(&StageTransitions[0], 0, sizeof(StageTransitions));
+}
+
+Metrics::Metrics() :
+		Workers(), Path(), ListenFD(-1), StopFD(-1), Thread(), Started(false) {
+}
+
+Metrics::~Metrics() {
+	stop();
+	for (size_t i = 0; i < Workers.size(); i++) {
+		delete Workers[i];
+	}
+}
+
+WorkerMetrics *Metrics::createWorker() {
+	WorkerMetrics *w = new WorkerMetrics();
+	Workers.push_back(w);
+	return w;
+}
+
+bool Metrics::start(const char *path) {
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "metrics socket path too long: %s\n", path);
+		return false;
+	}
+	strcpy(addr.sun_path, path);
+	ListenFD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	StopFD = eventfd(0, EFD_CLOEXEC);
+	if (ListenFD < 0 || StopFD < 0) {
+		perror("metrics socket");
+		return false;
+	}
+	unlink(path);
+	if (bind(ListenFD, (sockaddr *) &addr, sizeof(addr)) != 0 || listen(ListenFD, 16) != 0) {
+		perror("metrics bind");
+		return false;
+	}
+	Path = path;
+	if (pthread_create(&Thread, 0, serverMain, this) != 0) {
+		perror("pthread_create metrics");
+		return false;
+	}
+	Started = true;
+	return true;
+}
+
+void Metrics::stop() {
+	if (Started) {
+		uint64_t one = 1;
+		if (write(StopFD, &one, sizeof(one)) != sizeof(one)) {
+			perror("metrics stop");
+		}
+		pthread_join(Thread, 0);
+		Started = false;
+	}
+	if (ListenFD >= 0) {
+		close(ListenFD);
+		ListenFD = -1;
+		unlink(Path.c_str());
+	}
+	if (StopFD >= 0) {
+		close(StopFD);
+		StopFD = -1;
+	}
+}
+
+void *Metrics::serverMain(void *p) {
+	((Metrics *) p)->serve();
+	return 0;
+}
+
+void Metrics::serve() {
+	for (;;) {
+		pollfd fds[2];
+		fds[0].fd = ListenFD;
+		fds[0].events = POLLIN;
+		fds[1].fd = StopFD;
+		fds[1].events = POLLIN;
+		if (poll(&fds[0], 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("metrics poll");
+			return;
+		}
+		if (fds[1].revents) {
+			return;
+		}
+		int fd = accept4(ListenFD, 0, 0, SOCK_CLOEXEC);
+		if (fd >= 0) {
+			respond(fd);
+			close(fd);
+		}
+	}
+}
+
+//one snapshot, wrapped in HTTP if that's what was asked for. A bare client that sends nothing waits out the
+//receive timeout first
+void Metrics::respond(int fd) const {
+	timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = 100000;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	char request[1024];
+	int n = recv(fd, &request[0], sizeof(request), 0);
+	std::string body = format();
+	std::string response;
+	if (n >= 3 && memcmp(&request[0], "GET", 3) == 0) {
+		char header[160];
+		snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+				"Content-Length: %lu\r\nConnection: close\r\n\r\n", (unsigned long) body.length());
+		response = header;
+	}
+	response += body;
+	size_t sent = 0;
+	while (sent < response.length()) {
+		ssize_t w = send(fd, response.data() + sent, response.length() - sent, MSG_NOSIGNAL);
+		if (w <= 0) {
+			break;
+		}
+		sent += w;
+	}
+}
+
+static void appendHeader(std::string &out, const char *name, const char *type, const char *help) {
+	out += "# HELP ";
+	out += name;
+	out += " ";
+	out += help;
+	out += "\n# TYPE ";
+	out += name;
+	out += " ";
+	out += type;
+	out += "\n";
+}
+
+static void appendValue(std::string &out, const char *name, const char *labels, uint64_t value) {
+	char line[256];
+	snprintf(line, sizeof(line), "%s%s %llu\n", name, labels, (unsigned long long) value);
+	out += line;
+}
+
+//cumulative buckets for the ones that have anything in them, recorded in us and exported in seconds
+static void appendHistogram(std::string &out, const char *name, const char *label, const Histogram &h) {
+	char line[256];
+	uint64_t cumulative = 0;
+	for (uint32_t i = 0; i < Histogram::NUM_BUCKETS; i++) {
+		if (h.Counts[i] == 0) {
+			continue;
+		}
+		cumulative += h.Counts[i];
+		snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%g\"} %llu\n", name, label, *label ? "," : "",
+				Histogram::getBucketMax(i) / 1e6, (unsigned long long) cumulative);
+		out += line;
+	}
+	snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, label, *label ? "," : "",
+			(unsigned long long) h.Count);
+	out += line;
+	std::string braced = *label ? std::string("{") + label + "}" : std::string();
+	snprintf(line, sizeof(line), "%s_sum%s %g\n%s_count%s %llu\n", name, braced.c_str(), h.Sum / 1e6, name,
+			braced.c_str(), (unsigned long long) h.Count);
+	out += line;
+}
+
+std::string Metrics::format() const {
+	WorkerMetrics total;
+	for (size_t i = 0; i < Workers.size(); i++) {
+		const WorkerMetrics &w = *Workers[i];
+		//closes before accepts, so active can't come out negative
+		total.Closed += readCounter(w.Closed);
+		total.Accepts += readCounter(w.Accepts);
+		total.Refused += readCounter(w.Refused);
+		for (int s = 0; s < NUM_PUZZLE_STAGES; s++) {
+			total.StageTransitions[s] += readCounter(w.StageTransitions[s]);
+			total.StageTime[s].add(w.StageTime[s]);
+		}
+		total.WrongAnswers += readCounter(w.WrongAnswers);
+		total.IdleTimeouts += readCounter(w.IdleTimeouts);
+		total.ConnectionTimeouts += readCounter(w.ConnectionTimeouts);
+		total.BytesIn += readCounter(w.BytesIn);
+		total.BytesOut += readCounter(w.BytesOut);
+		total.SessionTime.add(w.SessionTime);
+	}
+	std::string out;
+	char label[64];
+	appendHeader(out, "boss_accepts_total", "counter", "Connections accepted.");
+	appendValue(out, "boss_accepts_total", "", total.Accepts);
+	appendHeader(out, "boss_refused_total", "counter", "Connections closed straight away because the pool was full.");
+	appendValue(out, "boss_refused_total", "", total.Refused);
+	appendHeader(out, "boss_active_sessions", "gauge", "Sessions currently connected.");
+	appendValue(out, "boss_active_sessions", "", total.Accepts - total.Closed);
+	appendHeader(out, "boss_stage_transitions_total", "counter", "Right answers, by the stage they finished.");
+	for (int s = 0; s < NUM_PUZZLE_STAGES; s++) {
+		snprintf(label, sizeof(label), "{stage=\"%d\"}", s);
+		appendValue(out, "boss_stage_transitions_total", label, total.StageTransitions[s]);
+	}
+	appendHeader(out, "boss_wrong_answers_total", "counter", "Sessions closed for a wrong answer.");
+	appendValue(out, "boss_wrong_answers_total", "", total.WrongAnswers);
+	appendHeader(out, "boss_timeouts_total", "counter", "Sessions closed for taking too long.");
+	appendValue(out, "boss_timeouts_total", "{type=\"idle\"}", total.IdleTimeouts);
+	appendValue(out, "boss_timeouts_total", "{type=\"connection\"}", total.ConnectionTimeouts);
+	appendHeader(out, "boss_received_bytes_total", "counter", "Bytes read from clients.");
+	appendValue(out, "boss_received_bytes_total", "", total.BytesIn);
+	appendHeader(out, "boss_sent_bytes_total", "counter", "Bytes sent to clients.");
+	appendValue(out, "boss_sent_bytes_total", "", total.BytesOut);
+	appendHeader(out, "boss_stage_duration_seconds", "histogram",
+			"Time from the previous right answer, or the connect, to a stage's right answer.");
+	for (int s = 0; s < NUM_PUZZLE_STAGES; s++) {
+		snprintf(label, sizeof(label), "stage=\"%d\"", s);
+		appendHistogram(out, "boss_stage_duration_seconds", label, total.StageTime[s]);
+	}
+	appendHeader(out, "boss_session_duration_seconds", "histogram", "Time from connect to close.");
+	appendHistogram(out, "boss_session_duration_seconds", "", total.SessionTime);
+	return out;
+}
@@ -0,0 +1,103 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+//answers in the puzzle, a stage is finished by its right answer
+#define NUM_PUZZLE_STAGES 7
+
+//Each counter has a single writer, its worker, so bumping one is a plain load and store with no lock prefix.
+//The stores are relaxed atomics only so the metrics thread never reads a torn value.
+inline void bumpCounter(uint64_t &counter, uint64_t n = 1) {
+	__atomic_store_n(&counter, counter + n, __ATOMIC_RELAXED);
+}
+
+inline uint64_t readCounter(const uint64_t &counter) {
+	return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+}
+
+//HDR style log-linear histogram of whole us: exact below 32, above that every power of two is split into
+//SUB_BUCKETS so a value lands in a bucket no wider than 1/16th of it. record is a clz, a shift and three bumps.
+class Histogram {
+public:
+	static const uint32_t SUB_BITS = 4;
+	static const uint32_t SUB_BUCKETS = 1 << SUB_BITS;
+	static const uint32_t NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+public:
+	Histogram();
+	void record(uint64_t value) {
+		bumpCounter(Counts[getBucket(value)]);
+		bumpCounter(Sum, value);
+		bumpCounter(Count);
+	}
+	//adds other into this, the metrics thread sums the workers' histograms this way
+	void add(const Histogram &other);
+	static uint32_t getBucket(uint64_t value) {
+		if (value < SUB_BUCKETS) {
+			return (uint32_t) value;
+		}
+		uint32_t exponent = 63 - __builtin_clzll(value);
+		return (exponent - SUB_BITS + 1) * SUB_BUCKETS + (uint32_t) ((value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+	}
+	//largest value that lands in bucket
+	static uint64_t getBucketMax(uint32_t bucket);
+public:
+	uint64_t Counts[NUM_BUCKETS];
+	uint64_t Sum;
+	uint64_t Count;
+};
+
+//one per worker, only that worker writes it
+struct WorkerMetrics {
+	uint64_t Accepts;
+	uint64_t Refused;
+	uint64_t Closed;
+	uint64_t StageTransitions[NUM_PUZZLE_STAGES];
+	uint64_t WrongAnswers;
+	uint64_t IdleTimeouts;
+	uint64_t ConnectionTimeouts;
+	uint64_t BytesIn;
+	uint64_t BytesOut;
+	//us from the previous right answer (or the connect) to this stage's right answer
+	Histogram StageTime[NUM_PUZZLE_STAGES];
+	//us from connect to close
+	Histogram SessionTime;
+
+	WorkerMetrics();
+};
+
+//Owns the workers' metrics and a thread serving their sum in the Prometheus text format on a UNIX socket.
+//Anything connecting gets one snapshot: an HTTP request (curl --unix-socket) gets it with a response header,
+//a bare connect (nc -U, socat) gets just the text.
+class Metrics {
+public:
+	Metrics();
+	~Metrics();
+	//all of them before start, they live until Metrics is destroyed
+	WorkerMetrics *createWorker();
+	//replaces whatever is at path with the metrics socket
+	bool start(const char *path);
+	//stops serving and removes the socket
+	void stop();
+	//the text one scrape returns
+	std::string format() const;
+private:
+	Metrics(const Metrics &);
+	Metrics &operator=(const Metrics &);
+	static void *serverMain(void *p);
+	void serve();
+	void respond(int fd) const;
+private:
+	std::vector<WorkerMetrics *> Workers;
+	std::string Path;
+	int ListenFD;
+	//written by stop to wake the serving thread
+	int StopFD;
+	pthread_t Thread;
+	bool Started;
+};
+
+#endif
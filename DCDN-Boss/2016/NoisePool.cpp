@@ -0,0 +1,63 @@
+#include "NoisePool.h"
+#include <string.h>
+
+static const char *CYBEREZ[7] = { "Cyberez Inc.", "Cyb3r3z 1nc.", "cYber3z", "debug: ok", "error: memory invalid",
+		"success", "jack of spades initialized" };
+
+static const char HEX_STRING[17] = "0123456789ABCDEF";
+
+NoisePool::NoisePool(uint64_t seed) :
+		State(0), NumReady(0) {
+	//splitmix64 so nearby seeds still start far apart, xorshift must not start at 0
+	seed += 0x9E3779B97F4A7C15ULL;
+	seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+	State = (seed ^ (seed >> 31)) | 1;
+	refill();
+}
+
+uint64_t NoisePool::next() {
+	State ^= State >> 12;
+	State ^= State << 25;
+	State ^= State >> 27;
+	return State * 0x2545F4914F6CDD1DULL;
+}
+
+void NoisePool::generate(char *p) {
+	static const uint32_t LENGTH = BLOCK_SIZE - 1;
+	//16 characters per word, the last word is only partly used
+	for (uint32_t i = 0; i < LENGTH; i += 16) {
+		uint64_t r = next();
+		uint32_t end = i + 16 < LENGTH ? i + 16 : LENGTH;
+		for (uint32_t j = i; j < end; j++) {
+			p[j] = HEX_STRING[r & 0xF];
+			r >>= 4;
+		}
+	}
+	//one more word decides the Cyberez string, each choice scales its own bits instead of taking a %. The odds are
+	//the old generator's: a 25% chance, then one of 3 places of which only the start and the middle are used
+	uint64_t r = next();
+	if (((r >> 32) * 100 >> 32) < 25) {
+		uint32_t loc = ((r & 0xFFFF) * 3) >> 16;
+		if (loc != 0) {
+			uint32_t where = loc == 1 ? 0 : BLOCK_SIZE / 2;
+			const char *s = CYBEREZ[(((r >> 16) & 0xFFFF) * 7) >> 16];
+			memcpy(&p[where], s, strlen(s));
+		}
+	}
+	p[LENGTH] = '\0';
+}
+
+const char *NoisePool::take() {
+	if (NumReady == 0) {
+		generate(Blocks[0]);
+		return Blocks[0];
+	}
+	return Blocks[--NumReady];
+}
+
+void NoisePool::refill() {
+	for (; NumReady < NUM_BLOCKS; NumReady++) {
+		generate(Blocks[NumReady]);
+	}
+}
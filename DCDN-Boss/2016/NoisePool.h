@@ -0,0 +1,31 @@
+#ifndef NOISE_POOL_H
+#define NOISE_POOL_H
+
+#include <stdint.h>
+
+//The hex noise sent after every prompt, one block in six carries one of the Cyberez strings at the start or in the
+//middle. One per worker: it runs its own xorshift64* so workers share no PRNG state, and it keeps
+//a stack of finished blocks the event loop tops up between wakeups so a reply only has to copy one.
+class NoisePool {
+public:
+	//BLOCK_SIZE - 1 characters of noise and a NUL, as the daemon has always sent
+	static const uint32_t BLOCK_SIZE = 128;
+	static const uint32_t NUM_BLOCKS = 64;
+public:
+	NoisePool(uint64_t seed);
+	//valid until the next refill, generated on the spot if the pool has run dry
+	const char *take();
+	//regenerates every block taken since the last refill
+	void refill();
+private:
+	NoisePool(const NoisePool &);
+	NoisePool &operator=(const NoisePool &);
+	uint64_t next();
+	void generate(char *p);
+private:
+	uint64_t State;
+	uint32_t NumReady;
+	char Blocks[NUM_BLOCKS][BLOCK_SIZE];
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+
+//Fixed capacity byte ring, storage is inline so a connection's buffers come with the connection and nothing is
+//allocated per message. CAPACITY must be a power of two, Head and Tail run freely and are masked on access.
+//Free space and data are handed out as at most two iovecs so readv/sendmsg work straight on the ring.
+template<uint32_t CAPACITY>
+class RingBuffer {
+public:
+	static const uint32_t MASK = CAPACITY - 1;
+public:
+	RingBuffer() :
+			Head(0), Tail(0) {
+	}
+	uint32_t getLength() const {
+		return Tail - Head;
+	}
+	uint32_t getFree() const {
+		return CAPACITY - getLength();
+	}
+	bool isFull() const {
+		return getLength() == CAPACITY;
+	}
+	char at(uint32_t i) const {
+		return Data[(Head + i) & MASK];
+	}
+	bool contains(const void *p) const {
+		return (const char *) p >= &Data[0] && (const char *) p < &Data[CAPACITY];
+	}
+	//the free space, fill it and commit
+	int getFree(iovec iov[2]) {
+		return split(Tail, getFree(), iov);
+	}
+	//the data, send it and consume
+	int getData(iovec iov[2]) {
+		return split(Head, getLength(), iov);
+	}
+	void commit(uint32_t n) {
+		Tail += n;
+	}
+	void consume(uint32_t n) {
+		Head += n;
+	}
+	void clear() {
+		Head = Tail;
+	}
+	//copies b in and returns where it landed, 0 iovecs if it doesn't fit
+	int append(const char *b, uint32_t n, iovec iov[2]) {
+		if (n > getFree()) {
+			return 0;
+		}
+		int num = split(Tail, n, iov);
+		for (int i = 0; i < num; i++) {
+			memcpy(iov[i].iov_base, b, iov[i].iov_len);
+			b += iov[i].iov_len;
+		}
+		Tail += n;
+		return num;
+	}
+private:
+	RingBuffer(const RingBuffer &);
+	RingBuffer &operator=(const RingBuffer &);
+	int split(uint32_t from, uint32_t n, iovec iov[2]) {
+		if (n == 0) {
+			return 0;
+		}
+		uint32_t at = from & MASK;
+		uint32_t first = CAPACITY - at;
+		iov[0].iov_base = &Data[at];
+		if (first >= n) {
+			iov[0].iov_len = n;
+			return 1;
+		}
+		iov[0].iov_len = first;
+		iov[1].iov_base = &Data[0];
+		iov[1].iov_len = n - first;
+		return 2;
+	}
+private:
+	uint32_t Head;
+	uint32_t Tail;
+	char Data[CAPACITY];
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "Server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+static const char Results[7][20] = { "MONA", "XfjnhD0ZQ8", "5zQXLfSo71", "E2ElmnWDuv", "MY8VBVunA6", "ZWxEcrPWc0",
+		"4OmUw7DuEo" };
+static const char Prompt[7][20] = { "#connection\n", "#datadown\n", "#dataup\n", "#keygen\n", "#10/6\n", "#initiate\n" };
+
+static const uint64_t MAX_MS_BETWEEN_DATA = Server::MAX_TIME_BETWEEN_DATA * 1000ULL;
+static const uint64_t MAX_MS_FOR_CONNECTION = Server::MAX_TIME_FOR_CONNECTION * 1000ULL;
+
+//wall clock jumps must not time out everybody at once
+static uint64_t monotonicUs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+Server::Server(int listenFD, int shutdownFD, uint32_t maxClients, LogRing *log, WorkerMetrics *metrics) :
+		ListenFD(listenFD), ShutdownFD(shutdownFD), MaxClients(maxClients), Log(log), Stats(metrics),
+		KeepRunning(true), NowUs(monotonicUs()), Now(NowUs / 1000), Timeouts(Now / TICK_MS), Clients(),
+		Noise(((uint64_t) time(0) << 32) ^ (uintptr_t) this) {
+}
+
+Server::~Server() {
+}
+
+bool Server::init() {
+	if (!Clients.init(MaxClients)) {
+		fprintf(stderr, "can't allocate %u client slots\n", MaxClients);
+		return false;
+	}
+	return true;
+}
+
+ClientInfo *Server::openSession(int fd, const in_addr &addr) {
+	ClientInfo *c = Clients.acquire();
+	if (!c) {
+		Log->push(Now, LOG_SERVER_FULL, addr, fd);
+		bumpCounter(Stats->Refused);
+		close(fd);
+		return 0;
+	}
+	c->open(fd, addr, Now, NowUs);
+	Log->push(Now, LOG_CONNECTED, c->Addr, c->FD);
+	bumpCounter(Stats->Accepts);
+	armTimeout(c);
+	return c;
+}
+
+void Server::shutdownAll() {
+	uint64_t one = 1;
+	if (write(ShutdownFD, &one, sizeof(one)) != sizeof(one)) {
+		perror("shutdown eventfd");
+	}
+	KeepRunning = false;
+}
+
+void Server::onRightAnswer(ClientInfo *c) {
+	bumpCounter(Stats->StageTransitions[c->RightAnswers]);
+	Stats->StageTime[c->RightAnswers].record(NowUs - c->StageStart);
+	c->StageStart = NowUs;
+	if (c->RightAnswers == 6) {
+		static const char *success = "March Hare daemon initialized.\nConnection Terminated";
+		c->bufferOutStatic(success, strlen(success));
+		shutdownAll();
+	} else {
+		c->bufferOutStatic(Prompt[c->RightAnswers], strlen(Prompt[c->RightAnswers]));
+		c->RightAnswers++;
+		c->bufferOut(Noise.take(), NoisePool::BLOCK_SIZE);
+	}
+}
+
+//Streams the input through the answer matcher, everything buffered is consumed and a partial answer is carried in
+//AnswerPos. An answer counts the moment its last byte matches so clients that don't send a newline still work,
+//line ends between answers are skipped and anything else that doesn't match is a wrong answer straight away.
+//Several pipelined answers are handled in one go, each queuing its reply behind the last, even when the client
+//closed its side right after sending them.
+void Server::handleInput(ClientInfo *c) {
+	uint32_t len = c->Input.getLength();
+	bool wrong = false;
+	for (uint32_t i = 0; i < len && !wrong && KeepRunning; i++) {
+		char ch = c->Input.at(i);
+		if (c->AnswerPos == 0 && (ch == '\n' || ch == '\r')) {
+			continue;
+		}
+		const char *expected = Results[c->RightAnswers];
+		if (ch != expected[c->AnswerPos]) {
+			Log->push(Now, LOG_WRONG_ANSWER, c->Addr, c->FD);
+			bumpCounter(Stats->WrongAnswers);
+			const char *message = "Incorrect code.\nConnection closed.";
+			c->bufferOutStatic(message, strlen(message));
+			c->Dead = true;
+			wrong = true;
+		} else if (expected[++c->AnswerPos] == '\0') {
+			c->AnswerPos = 0;
+			onRightAnswer(c);
+		}
+	}
+	c->Input.consume(len);
+	if (c->PeerClosed) {
+		c->Dead = true;
+	}
+}
+
+void Server::endSession(ClientInfo *c) {
+	Timeouts.cancel(&c->Timer);
+	Log->push(Now, LOG_DROPPED, c->Addr, c->FD);
+	bumpCounter(Stats->Closed);
+	Stats->SessionTime.record(NowUs - c->ConnectTimeUs);
+}
+
+//first tick at or after the session's deadline, a no-op when that hasn't moved
+void Server::armTimeout(ClientInfo *c) {
+	uint64_t deadline = c->getDeadline(MAX_MS_BETWEEN_DATA, MAX_MS_FOR_CONNECTION);
+	uint64_t tick = (deadline + TICK_MS - 1) / TICK_MS;
+	if (!c->Timer.isArmed() || c->Timer.Expiry != tick) {
+		Timeouts.schedule(&c->Timer, tick);
+	}
+}
+
+void Server::onTimeout(TimerNode *node, void *ctx) {
+	Server *s = (Server *) ctx;
+	ClientInfo *c = (ClientInfo *) node->Owner;
+	if (s->Now - c->LastDataReceived > MAX_MS_BETWEEN_DATA) {
+		s->Log->push(s->Now, LOG_IDLE_TIMEOUT, c->Addr, c->FD);
+		bumpCounter(s->Stats->IdleTimeouts);
+	}
+	if (s->Now - c->ConnectTime > MAX_MS_FOR_CONNECTION) {
+		s->Log->push(s->Now, LOG_CONNECTION_TIMEOUT, c->Addr, c->FD);
+		bumpCounter(s->Stats->ConnectionTimeouts);
+	}
+	s->drop(c);
+}
+
+void Server::updateNow() {
+	NowUs = monotonicUs();
+	Now = NowUs / 1000;
+}
+
+void Server::runTimeouts() {
+	Timeouts.advance(Now / TICK_MS, &Server::onTimeout, this);
+}
+
+int Server::getTimeout() const {
+	uint64_t next = Timeouts.getNextExpiry();
+	if (next == TimerWheel::NEVER) {
+		return -1;
+	}
+	uint64_t at = next * TICK_MS;
+	return at <= Now ? 0 : (int) (at - Now);
+}
+
@@ -0,0 +1,75 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include "AsyncLog.h"
+#include "ClientInfo.h"
+#include "ClientPool.h"
+#include "Metrics.h"
+#include "NoisePool.h"
+#include "TimerWheel.h"
+
+//One worker running the March Hare puzzle. This is the part every networking backend shares: the session slots,
+//the answer state machine, the timeouts, noise, logging and metrics. The backends (EpollServer, UringServer) move
+//the bytes and call back in here; a backend reads into a session's Input and calls handleInput, sends whatever
+//that left in its output queue and calls drop when the session is over.
+//Every session's deadline sits in a timer wheel, re-armed in O(1) when data arrives, and a backend sleeps until
+//getTimeout says the wheel's next expiry is due.
+//With --workers every thread runs its own Server on its own SO_REUSEPORT listen socket, the only thing they
+//share is shutdownFD: an eventfd that becomes readable for every worker once anyone initializes the daemon.
+class Server {
+public:
+	static const int MAX_TIME_BETWEEN_DATA = 120;
+	static const int MAX_TIME_FOR_CONNECTION = MAX_TIME_BETWEEN_DATA * 4;
+	//timer wheel resolution, sessions are dropped at most this late
+	static const uint64_t TICK_MS = 100;
+	//how long to back off accepting when out of file descriptors
+	static const int ACCEPT_RETRY_MS = 100;
+public:
+	//listenFD is bound, listening and non-blocking, shutdownFD is the workers' shared eventfd, Server owns neither.
+	//Connections past maxClients are closed as soon as they are accepted. Events go to log and counts to
+	//metrics, this worker is the only writer of both
+	Server(int listenFD, int shutdownFD, uint32_t maxClients, LogRing *log, WorkerMetrics *metrics);
+	virtual ~Server();
+	//false if the backend or the client pool can't be set up
+	virtual bool init();
+	//until someone initializes the daemon on any worker
+	virtual void run() = 0;
+protected:
+	//a slot for a freshly accepted fd, 0 (and the fd closed) when the pool is full
+	ClientInfo *openSession(int fd, const in_addr &addr);
+	//runs everything buffered in Input through the answer matcher
+	void handleInput(ClientInfo *c);
+	//the backend's part of ending a session, it has to call endSession
+	virtual void drop(ClientInfo *c) = 0;
+	//stops the timeout and accounts for the session, the backend still owns the fd and the slot
+	void endSession(ClientInfo *c);
+	void armTimeout(ClientInfo *c);
+	//reads the clock, call once per wakeup
+	void updateNow();
+	void runTimeouts();
+	//ms until the wheel's next expiry, -1 (forever) with nothing armed
+	int getTimeout() const;
+	void shutdownAll();
+private:
+	Server(const Server &);
+	Server &operator=(const Server &);
+	void onRightAnswer(ClientInfo *c);
+	static void onTimeout(TimerNode *node, void *ctx);
+protected:
+	int ListenFD;
+	int ShutdownFD;
+	uint32_t MaxClients;
+	LogRing *Log;
+	WorkerMetrics *Stats;
+	bool KeepRunning;
+	//the monotonic clock read once per wakeup, in us for the latency histograms and in ms for everything else
+	uint64_t NowUs;
+	uint64_t Now;
+	TimerWheel Timeouts;
+	ClientPool Clients;
+	NoisePool Noise;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "TimerWheel.h"
+
+TimerNode::TimerNode(void *owner) :
+		Prev(0), Next(0), Expiry(0), Owner(owner) {
+}
+
+bool TimerNode::isArmed() const {
+	return Next != 0;
+}
+
+static void initHead(TimerNode *head) {
+	head->Prev = head->Next = head;
+}
+
+static bool isEmpty(const TimerNode *head) {
+	return head->Next == head;
+}
+
+TimerWheel::TimerWheel(uint64_t now) :
+		Now(now), NumArmed(0) {
+	for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+		initHead(&Level0[i]);
+		initHead(&Level1[i]);
+	}
+}
+
+void TimerWheel::unlink(TimerNode *node) {
+	node->Prev->Next = node->Next;
+	node->Next->Prev = node->Prev;
+	node->Prev = node->Next = 0;
+}
+
+//files node by how far away it is, never into a slot before earliest
+void TimerWheel::link(TimerNode *node, uint64_t earliest) {
+	uint64_t tick = node->Expiry > earliest ? node->Expiry : earliest;
+	TimerNode *head;
+	if (tick - Now < NUM_SLOTS) {
+		head = &Level0[tick & (NUM_SLOTS - 1)];
+	} else {
+		uint64_t block = tick >> SLOT_BITS, nowBlock = Now >> SLOT_BITS;
+		head = &Level1[(block - nowBlock < NUM_SLOTS ? block : nowBlock + NUM_SLOTS - 1) & (NUM_SLOTS - 1)];
+	}
+	node->Prev = head->Prev;
+	node->Next = head;
+	head->Prev->Next = node;
+	head->Prev = node;
+}
+
+void TimerWheel::schedule(TimerNode *node, uint64_t expiry) {
+	if (node->isArmed()) {
+		unlink(node);
+	} else {
+		NumArmed++;
+	}
+	node->Expiry = expiry;
+	//the slot for Now has already run
+	link(node, Now + 1);
+}
+
+void TimerWheel::cancel(TimerNode *node) {
+	if (node->isArmed()) {
+		unlink(node);
+		NumArmed--;
+	}
+}
+
+void TimerWheel::advance(uint64_t now, TimerCallback cb, void *ctx) {
+	if (NumArmed == 0 && now > Now) {
+		Now = now;
+		return;
+	}
+	while (Now < now) {
+		Now++;
+		if ((Now & (NUM_SLOTS - 1)) == 0) {
+			//a new block starts, spread its level 1 slot over level 0 before the slot for Now runs
+			TimerNode pending;
+			TimerNode *head = &Level1[(Now >> SLOT_BITS) & (NUM_SLOTS - 1)];
+			if (!isEmpty(head)) {
+				pending.Next = head->Next;
+				pending.Prev = head->Prev;
+				pending.Next->Prev = pending.Prev->Next = &pending;
+				initHead(head);
+				while (!isEmpty(&pending)) {
+					TimerNode *node = pending.Next;
+					unlink(node);
+					link(node, Now);
+				}
+			}
+		}
+		TimerNode *head = &Level0[Now & (NUM_SLOTS - 1)];
+		while (!isEmpty(head)) {
+			TimerNode *node = head->Next;
+			unlink(node);
+			NumArmed--;
+			cb(node, ctx);
+		}
+	}
+}
+
+uint64_t TimerWheel::getNextExpiry() const {
+	if (NumArmed == 0) {
+		return NEVER;
+	}
+	uint64_t next = NEVER;
+	for (uint64_t t = Now + 1; t < Now + NUM_SLOTS; t++) {
+		if (!isEmpty(&Level0[t & (NUM_SLOTS - 1)])) {
+			next = t;
+			break;
+		}
+	}
+	//a block that cascades before that may hold something sooner
+	uint64_t nowBlock = Now >> SLOT_BITS;
+	for (uint64_t b = nowBlock + 1; b <= nowBlock + NUM_SLOTS; b++) {
+		if ((b << SLOT_BITS) >= next) {
+			break;
+		}
+		if (!isEmpty(&Level1[b & (NUM_SLOTS - 1)])) {
+			return b << SLOT_BITS;
+		}
+	}
+	return next;
+}
@@ -0,0 +1,51 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+//intrusive, lives in whatever it times out
+struct TimerNode {
+	TimerNode *Prev;
+	TimerNode *Next;
+	uint64_t Expiry;
+	void *Owner;
+	TimerNode(void *owner = 0);
+	bool isArmed() const;
+};
+
+typedef void (*TimerCallback)(TimerNode *node, void *ctx);
+
+//Two level hierarchical timer wheel in ticks (the caller picks the tick length).
+//Level 0 has a slot per tick for the next 256 ticks, level 1 a slot per 256 ticks for the 256 blocks after that;
+//anything further out parks in the last level 1 slot and is re-filed each time it cascades.
+//schedule and cancel are O(1) list splices, advance only touches slots that come due plus one level 1 slot
+//every 256 ticks, getNextExpiry looks at no more than 512 slot heads.
+class TimerWheel {
+public:
+	static const uint32_t SLOT_BITS = 8;
+	static const uint32_t NUM_SLOTS = 1 << SLOT_BITS;
+	static const uint64_t NEVER = ~0ULL;
+public:
+	TimerWheel(uint64_t now);
+	//(re)arms node for expiry, an expiry at or before now fires on the next advance
+	void schedule(TimerNode *node, uint64_t expiry);
+	void cancel(TimerNode *node);
+	//runs cb for every node due at or before now, each is disarmed before its callback and may be rescheduled
+	void advance(uint64_t now, TimerCallback cb, void *ctx);
+	//the tick advance next has work to do at, NEVER when empty. Exact for timers in the next 256 ticks,
+	//otherwise the tick their block cascades, which is never late
+	uint64_t getNextExpiry() const;
+private:
+	TimerWheel(const TimerWheel &);
+	TimerWheel &operator=(const TimerWheel &);
+	void link(TimerNode *node, uint64_t earliest);
+	static void unlink(TimerNode *node);
+private:
+	uint64_t Now;
+	uint32_t NumArmed;
+	//list heads, a slot is empty when its head points at itself
+	TimerNode Level0[NUM_SLOTS];
+	TimerNode Level1[NUM_SLOTS];
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "Uring.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static int setup(uint32_t entries, io_uring_params *p) {
+	return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int enter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags, void *arg, size_t argSize) {
+	return (int) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+static int registerRing(int fd, uint32_t opcode, void *arg, uint32_t numArgs) {
+	return (int) syscall(__NR_io_uring_register, fd, opcode, arg, numArgs);
+}
+
+Uring::Uring() :
+		FD(-1), SqRing(MAP_FAILED), SqRingSize(0), CqRing(MAP_FAILED), CqRingSize(0), Sqes((io_uring_sqe *) MAP_FAILED),
+		SqesSize(0), SqHead(0), SqTail(0), SqMask(0), SqEntries(0), SqArray(0), LocalTail(0), CqHead(0), CqTail(0),
+		CqMask(0), Cqes(0) {
+}
+
+Uring::~Uring() {
+	if (Sqes != MAP_FAILED) {
+		munmap(Sqes, SqesSize);
+	}
+	if (CqRing != MAP_FAILED && CqRing != SqRing) {
+		munmap(CqRing, CqRingSize);
+	}
+	if (SqRing != MAP_FAILED) {
+		munmap(SqRing, SqRingSize);
+	}
+	if (FD >= 0) {
+		close(FD);
+	}
+}
+
+bool Uring::init(uint32_t entries, uint32_t cqEntries) {
+	io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	//only this thread submits and completions are reaped on our way into the kernel anyway, so no IPIs needed
+	p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+	p.cq_entries = cqEntries;
+	FD = setup(entries, &p);
+	if (FD < 0 && errno == EINVAL) {
+		memset(&p, 0, sizeof(p));
+		p.flags = IORING_SETUP_CQSIZE;
+		p.cq_entries = cqEntries;
+		FD = setup(entries, &p);
+	}
+	if (FD < 0) {
+		return false;
+	}
+	if (!(p.features & IORING_FEAT_EXT_ARG)) {
+		errno = ENOSYS;
+		return false;
+	}
+	SqRingSize = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+	CqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (CqRingSize > SqRingSize) {
+			SqRingSize = CqRingSize;
+		}
+		CqRingSize = SqRingSize;
+	}
+	SqRing = mmap(0, SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, FD, IORING_OFF_SQ_RING);
+	if (SqRing == MAP_FAILED) {
+		return false;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		CqRing = SqRing;
+	} else {
+		CqRing = mmap(0, CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, FD, IORING_OFF_CQ_RING);
+		if (CqRing == MAP_FAILED) {
+			return false;
+		}
+	}
+	SqesSize = p.sq_entries * sizeof(io_uring_sqe);
+	Sqes = (io_uring_sqe *) mmap(0, SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, FD, IORING_OFF_SQES);
+	if (Sqes == MAP_FAILED) {
+		return false;
+	}
+	char *sq = (char *) SqRing;
+	SqHead = (uint32_t *) (sq + p.sq_off.head);
+	SqTail = (uint32_t *) (sq + p.sq_off.tail);
+	SqMask = *(uint32_t *) (sq + p.sq_off.ring_mask);
+	SqEntries = p.sq_entries;
+	SqArray = (uint32_t *) (sq + p.sq_off.array);
+	LocalTail = *SqTail;
+	char *cq = (char *) CqRing;
+	CqHead = (uint32_t *) (cq + p.cq_off.head);
+	CqTail = (uint32_t *) (cq + p.cq_off.tail);
+	CqMask = *(uint32_t *) (cq + p.cq_off.ring_mask);
+	Cqes = (io_uring_cqe *) (cq + p.cq_off.cqes);
+	return true;
+}
+
+io_uring_sqe *Uring::getSqe() {
+	if (LocalTail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE) == SqEntries) {
+		//without SQPOLL the kernel consumes everything it's given before enter returns
+		if (submit(0, 0, 0, 0) < 0) {
+			return 0;
+		}
+	}
+	uint32_t index = LocalTail & SqMask;
+	io_uring_sqe *sqe = &Sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	SqArray[index] = index;
+	LocalTail++;
+	return sqe;
+}
+
+int Uring::submit(uint32_t minComplete, uint32_t flags, void *arg, size_t argSize) {
+	//whatever the kernel hasn't consumed yet, including anything a failed enter left behind
+	uint32_t toSubmit = LocalTail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE);
+	__atomic_store_n(SqTail, LocalTail, __ATOMIC_RELEASE);
+	if (toSubmit == 0 && minComplete == 0) {
+		return 0;
+	}
+	int n = enter(FD, toSubmit, minComplete, flags, arg, argSize);
+	return n < 0 ? -errno : 0;
+}
+
+int Uring::submitAndWait(int timeoutMs) {
+	if (timeoutMs < 0) {
+		return submit(1, IORING_ENTER_GETEVENTS, 0, 0);
+	}
+	__kernel_timespec ts;
+	ts.tv_sec = timeoutMs / 1000;
+	ts.tv_nsec = (long long) (timeoutMs % 1000) * 1000000;
+	io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	arg.sigmask_sz = _NSIG / 8;
+	arg.ts = (uint64_t) (uintptr_t) &ts;
+	return submit(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+io_uring_cqe *Uring::peek() {
+	uint32_t head = *CqHead;
+	if (head == __atomic_load_n(CqTail, __ATOMIC_ACQUIRE)) {
+		return 0;
+	}
+	return &Cqes[head & CqMask];
+}
+
+void Uring::seen() {
+	__atomic_store_n(CqHead, *CqHead + 1, __ATOMIC_RELEASE);
+}
+
+bool Uring::isSupported(uint8_t op) const {
+	size_t size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+	io_uring_probe *probe = (io_uring_probe *) calloc(1, size);
+	if (!probe) {
+		return false;
+	}
+	bool supported = registerRing(FD, IORING_REGISTER_PROBE, probe, 256) == 0 && op <= probe->last_op
+			&& (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+	free(probe);
+	return supported;
+}
+
+bool Uring::registerBufferRing(io_uring_buf_ring *ring, uint32_t entries, uint16_t bgid) {
+	io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t) (uintptr_t) ring;
+	reg.ring_entries = entries;
+	reg.bgid = bgid;
+	return registerRing(FD, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+}
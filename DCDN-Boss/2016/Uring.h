@@ -0,0 +1,54 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+//The bare minimum of io_uring over the raw syscalls: one submission and one completion ring mapped into the
+//process, SQEs handed out zeroed and pushed to the kernel on the next submit, CQEs read in place.
+//Only one thread may use it, the ring is set up single issuer where the kernel allows it.
+class Uring {
+public:
+	Uring();
+	~Uring();
+	//false, with errno set, if the kernel can't give us a ring that waits with a timeout
+	bool init(uint32_t entries, uint32_t cqEntries);
+	//a zeroed SQE, submitting what's queued first if the ring is full. 0 if even that fails
+	io_uring_sqe *getSqe();
+	//submits everything queued and waits up to timeoutMs (-1 forever) for a completion. 0, or -errno with
+	//-ETIME and -EINTR meaning nothing is wrong
+	int submitAndWait(int timeoutMs);
+	//the oldest unseen completion or 0, seen() hands its slot back to the kernel
+	io_uring_cqe *peek();
+	void seen();
+	//whether the kernel knows op
+	bool isSupported(uint8_t op) const;
+	//shares a ring of provided buffers with the kernel as group bgid, ring has to be page aligned
+	bool registerBufferRing(io_uring_buf_ring *ring, uint32_t entries, uint16_t bgid);
+private:
+	Uring(const Uring &);
+	Uring &operator=(const Uring &);
+	int submit(uint32_t minComplete, uint32_t flags, void *arg, size_t argSize);
+private:
+	int FD;
+	void *SqRing;
+	size_t SqRingSize;
+	void *CqRing;
+	size_t CqRingSize;
+	io_uring_sqe *Sqes;
+	size_t SqesSize;
+	uint32_t *SqHead;
+	uint32_t *SqTail;
+	uint32_t SqMask;
+	uint32_t SqEntries;
+	uint32_t *SqArray;
+	//SQEs handed out but not yet pushed to the kernel end at LocalTail
+	uint32_t LocalTail;
+	uint32_t *CqHead;
+	uint32_t *CqTail;
+	uint32_t CqMask;
+	io_uring_cqe *Cqes;
+};
+
+#endif
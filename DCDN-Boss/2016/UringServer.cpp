@@ -0,0 +1,462 @@
+#include "UringServer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+//what a slot has in flight, one bit per op
+static const uint8_t IN_RECV = 1 << 0;
+static const uint8_t IN_SEND = 1 << 1;
+static const uint8_t IN_CLOSE = 1 << 2;
+//the groups our receive buffers are provided as, a ring can't be swapped for plain buffers in the same group
+static const uint16_t BUFFER_RING_GROUP = 0;
+static const uint16_t PROVIDED_GROUP = 1;
+
+//user_data is the slot and the op, so a completion finds its session without a lookup
+static uint64_t makeTag(uint8_t op, uint32_t slot) {
+	return (uint64_t) slot << 8 | op;
+}
+
+UringServer::UringServer(int listenFD, int shutdownFD, uint32_t maxClients, LogRing *log, WorkerMetrics *metrics) :
+		Server(listenFD, shutdownFD, maxClients, log, metrics), Ring(), Slots(0), RecvBuffers(0),
+		BufferRing((io_uring_buf_ring *) MAP_FAILED), BufferRingSize(0), BufferTail(0), UseBufferRing(false),
+		BufferGroup(PROVIDED_GROUP), AcceptPaused(false),
+		AcceptRetryAt(0), NumClosing(0) {
+}
+
+UringServer::~UringServer() {
+	//armed recvs write into RecvBuffers and sends read a slot's Msg until the kernel is done with them, which is
+	//only for sure once it has nothing of ours left
+	bool idle = !RecvBuffers || cancelAll();
+	//a CLOSE that was queued may or may not have happened, don't let the pool close the fd again once it could be
+	//someone else's
+	for (uint32_t i = 0; Slots && i < Clients.getCapacity(); i++) {
+		if (Slots[i].CloseQueued) {
+			Clients.getSlot(i)->FD = -1;
+		}
+	}
+	if (!idle) {
+		//better leaked than written into after the free
+		return;
+	}
+	delete[] Slots;
+	delete[] RecvBuffers;
+	if (BufferRing != MAP_FAILED) {
+		munmap(BufferRing, BufferRingSize);
+	}
+}
+
+bool UringServer::init() {
+	if (!Ring.init(SQ_ENTRIES, CQ_ENTRIES)) {
+		perror("io_uring_setup");
+		return false;
+	}
+	//multishot recv came with 6.0 and nothing flags it, zero copy send came in the same release
+	if (!Ring.isSupported(IORING_OP_SEND_ZC)) {
+		fprintf(stderr, "io_uring: kernel too old for multishot recv\n");
+		return false;
+	}
+	if (!setupBuffers() || !Server::init()) {
+		return false;
+	}
+	Slots = new Slot[Clients.getCapacity()];
+	memset(Slots, 0, sizeof(Slot) * Clients.getCapacity());
+	armAccept();
+	armShutdown();
+	return true;
+}
+
+io_uring_sqe *UringServer::getSqe(uint8_t op, uint32_t slot) {
+	io_uring_sqe *sqe = Ring.getSqe();
+	if (!sqe) {
+		//only when io_uring_enter itself fails, nothing we could do about it would work either
+		perror("io_uring_enter");
+		abort();
+	}
+	sqe->user_data = makeTag(op, slot);
+	return sqe;
+}
+
+void UringServer::armAccept() {
+	io_uring_sqe *sqe = getSqe(OP_ACCEPT, 0);
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = ListenFD;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_CLOEXEC;
+}
+
+//one shot and never read, so it stays readable for every worker
+void UringServer::armShutdown() {
+	io_uring_sqe *sqe = getSqe(OP_SHUTDOWN, 0);
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = ShutdownFD;
+	sqe->poll32_events = POLLIN;
+}
+
+void UringServer::armRecv(uint32_t slot, int fd) {
+	io_uring_sqe *sqe = getSqe(OP_RECV, slot);
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BufferGroup;
+	Slots[slot].InFlight |= IN_RECV;
+}
+
+//everything queued in one SENDMSG, the data stays put in Output until the completion says it's gone.
+//A linked send is the last one, WAITALL so a short write fails the CLOSE behind it rather than losing the rest
+void UringServer::send(uint32_t slot, ClientInfo *c, bool link) {
+	Slot &s = Slots[slot];
+	memset(&s.Msg, 0, sizeof(s.Msg));
+	s.Msg.msg_iov = &s.Iov[0];
+	s.Msg.msg_iovlen = c->getOutput(&s.Iov[0]);
+	io_uring_sqe *sqe = getSqe(OP_SEND, slot);
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = c->FD;
+	sqe->addr = (uint64_t) (uintptr_t) &s.Msg;
+	sqe->len = 1;
+	sqe->msg_flags = MSG_NOSIGNAL | (link ? MSG_WAITALL : 0);
+	if (link) {
+		sqe->flags = IOSQE_IO_LINK;
+	}
+	s.InFlight |= IN_SEND;
+}
+
+void UringServer::cancel(uint32_t slot, uint8_t op) {
+	io_uring_sqe *sqe = getSqe(OP_CANCEL, slot);
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = makeTag(op, slot);
+}
+
+void UringServer::queueClose(uint32_t slot, ClientInfo *c) {
+	io_uring_sqe *sqe = getSqe(OP_CLOSE, slot);
+	sqe->opcode = IORING_OP_CLOSE;
+	sqe->fd = c->FD;
+	Slots[slot].InFlight |= IN_CLOSE;
+	Slots[slot].CloseQueued = true;
+}
+
+//Ends a session: its recv is cancelled and whatever is left to send goes out linked to the CLOSE. The slot comes
+//back once every op on it has completed. The timeout stays armed until then, a client that never reads its last
+//reply is cut off like any other
+void UringServer::finish(uint32_t slot, ClientInfo *c) {
+	Slot &s = Slots[slot];
+	if (!s.Closing) {
+		s.Closing = true;
+		NumClosing++;
+		if (s.InFlight & IN_RECV) {
+			cancel(slot, OP_RECV);
+		}
+	}
+	advanceClose(slot, c);
+}
+
+void UringServer::advanceClose(uint32_t slot, ClientInfo *c) {
+	Slot &s = Slots[slot];
+	if (!s.CloseQueued && !(s.InFlight & IN_SEND)) {
+		if (!s.Abort && c->hasOutput()) {
+			send(slot, c, true);
+		}
+		queueClose(slot, c);
+	}
+	if (s.InFlight == 0) {
+		endSession(c);
+		s.Closing = s.Abort = s.CloseQueued = false;
+		NumClosing--;
+		//already closed
+		c->FD = -1;
+		Clients.release(c);
+	}
+}
+
+void UringServer::drop(ClientInfo *c) {
+	uint32_t slot = Clients.getIndex(c);
+	Slot &s = Slots[slot];
+	s.Abort = true;
+	if (s.InFlight & IN_SEND) {
+		cancel(slot, OP_SEND);
+	}
+	finish(slot, c);
+}
+
+//after a session's state changed: sends what it has queued unless a send is already out, ends it if it's over.
+//Solving the puzzle ends the session too, with the success message
+void UringServer::afterIO(uint32_t slot, ClientInfo *c) {
+	Slot &s = Slots[slot];
+	if (s.Closing) {
+		advanceClose(slot, c);
+	} else if (c->Dead || !KeepRunning) {
+		finish(slot, c);
+	} else {
+		if (c->hasOutput() && !(s.InFlight & IN_SEND)) {
+			send(slot, c, false);
+		}
+		armTimeout(c);
+	}
+}
+
+void UringServer::onAccept(const io_uring_cqe *cqe) {
+	if (cqe->res >= 0) {
+		int fd = cqe->res;
+		sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+		memset(&addr, 0, sizeof(addr));
+		//multishot accept has nowhere to put each peer's address
+		getpeername(fd, (sockaddr *) &addr, &len);
+		ClientInfo *c = openSession(fd, addr.sin_addr);
+		if (c) {
+			armRecv(Clients.getIndex(c), fd);
+		}
+	} else if (cqe->res == -EMFILE || cqe->res == -ENFILE || cqe->res == -ENOBUFS || cqe->res == -ENOMEM) {
+		errno = -cqe->res;
+		perror("accept");
+		//out of descriptors ends the multishot, try again in a bit rather than straight away
+		if (!(cqe->flags & IORING_CQE_F_MORE)) {
+			AcceptPaused = true;
+			AcceptRetryAt = Now + ACCEPT_RETRY_MS;
+		}
+		return;
+	}
+	if (!(cqe->flags & IORING_CQE_F_MORE)) {
+		armAccept();
+	}
+}
+
+//A buffer ring if the kernel has one that works, some accept the registration and then never hand out a buffer.
+//Otherwise the buffers are provided the old way, which costs an SQE per buffer but no extra syscalls
+bool UringServer::setupBuffers() {
+	RecvBuffers = new char[(size_t) NUM_RECV_BUFFERS * RECV_BUFFER_SIZE];
+	BufferRingSize = NUM_RECV_BUFFERS * sizeof(io_uring_buf);
+	BufferRing = (io_uring_buf_ring *) mmap(0, BufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0);
+	if (BufferRing != MAP_FAILED && Ring.registerBufferRing(BufferRing, NUM_RECV_BUFFERS, BUFFER_RING_GROUP)) {
+		UseBufferRing = true;
+		BufferGroup = BUFFER_RING_GROUP;
+		for (uint32_t i = 0; i < NUM_RECV_BUFFERS; i++) {
+			recycleBuffer((uint16_t) i);
+		}
+		__atomic_store_n(&BufferRing->tail, BufferTail, __ATOMIC_RELEASE);
+		if (checkBuffers(BufferGroup)) {
+			return true;
+		}
+		UseBufferRing = false;
+	}
+	BufferGroup = PROVIDED_GROUP;
+	io_uring_sqe *sqe = getSqe(OP_PROVIDE, 0);
+	sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+	sqe->fd = NUM_RECV_BUFFERS;
+	sqe->addr = (uint64_t) (uintptr_t) RecvBuffers;
+	sqe->len = RECV_BUFFER_SIZE;
+	sqe->buf_group = BufferGroup;
+	if (!checkBuffers(BufferGroup)) {
+		fprintf(stderr, "io_uring: can't receive into provided buffers\n");
+		return false;
+	}
+	return true;
+}
+
+//one recv on a socketpair, true if it came back with a buffer from group, which goes back to the kernel
+bool UringServer::checkBuffers(uint16_t group) {
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+		return false;
+	}
+	bool ok = false;
+	if (write(fds[1], "x", 1) == 1) {
+		io_uring_sqe *sqe = getSqe(OP_CHECK, 0);
+		sqe->opcode = IORING_OP_RECV;
+		sqe->fd = fds[0];
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = group;
+		bool done = false;
+		while (!done && Ring.submitAndWait(1000) == 0) {
+			io_uring_cqe *cqe;
+			while ((cqe = Ring.peek()) != 0) {
+				if ((uint8_t) cqe->user_data == OP_CHECK) {
+					done = true;
+					ok = cqe->res == 1 && (cqe->flags & IORING_CQE_F_BUFFER);
+					if (cqe->flags & IORING_CQE_F_BUFFER) {
+						recycleBuffer(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+					}
+				}
+				Ring.seen();
+			}
+		}
+	}
+	close(fds[0]);
+	close(fds[1]);
+	if (UseBufferRing) {
+		__atomic_store_n(&BufferRing->tail, BufferTail, __ATOMIC_RELEASE);
+	}
+	return ok;
+}
+
+void UringServer::recycleBuffer(uint16_t id) {
+	char *b = &RecvBuffers[(size_t) id * RECV_BUFFER_SIZE];
+	if (UseBufferRing) {
+		io_uring_buf &buf = BufferRing->bufs[BufferTail & (NUM_RECV_BUFFERS - 1)];
+		buf.addr = (uint64_t) (uintptr_t) b;
+		buf.len = RECV_BUFFER_SIZE;
+		buf.bid = id;
+		BufferTail++;
+	} else {
+		io_uring_sqe *sqe = getSqe(OP_PROVIDE, 0);
+		sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+		sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+		sqe->fd = 1;
+		sqe->addr = (uint64_t) (uintptr_t) b;
+		sqe->len = RECV_BUFFER_SIZE;
+		sqe->buf_group = BufferGroup;
+		sqe->off = id;
+	}
+}
+
+void UringServer::onRecv(uint32_t slot, const io_uring_cqe *cqe) {
+	Slot &s = Slots[slot];
+	ClientInfo *c = Clients.getSlot(slot);
+	bool more = cqe->flags & IORING_CQE_F_MORE;
+	if (!more) {
+		s.InFlight &= ~IN_RECV;
+	}
+	if (cqe->flags & IORING_CQE_F_BUFFER) {
+		uint16_t id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+		if (cqe->res > 0 && !s.Closing) {
+			c->bufferIn(&RecvBuffers[(size_t) id * RECV_BUFFER_SIZE], cqe->res, Now);
+			bumpCounter(Stats->BytesIn, cqe->res);
+			handleInput(c);
+		}
+		recycleBuffer(id);
+	}
+	if (!s.Closing) {
+		if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS)) {
+			c->Dead = true;
+		} else if (!more) {
+			//out of buffers, they are back by the time this is submitted
+			armRecv(slot, c->FD);
+		}
+	}
+	afterIO(slot, c);
+}
+
+void UringServer::onSend(uint32_t slot, const io_uring_cqe *cqe) {
+	ClientInfo *c = Clients.getSlot(slot);
+	Slots[slot].InFlight &= ~IN_SEND;
+	if (cqe->res > 0) {
+		c->popSent(cqe->res);
+		bumpCounter(Stats->BytesOut, cqe->res);
+	} else if (cqe->res < 0) {
+		c->Dead = true;
+		Slots[slot].Abort = true;
+	}
+	afterIO(slot, c);
+}
+
+//a CLOSE linked behind a send that failed or came up short is cancelled, the fd still has to go
+void UringServer::onClose(uint32_t slot, const io_uring_cqe *cqe) {
+	ClientInfo *c = Clients.getSlot(slot);
+	Slots[slot].InFlight &= ~IN_CLOSE;
+	if (cqe->res == -ECANCELED) {
+		queueClose(slot, c);
+	}
+	advanceClose(slot, c);
+}
+
+void UringServer::reap() {
+	io_uring_cqe *cqe;
+	while ((cqe = Ring.peek()) != 0) {
+		uint8_t op = (uint8_t) cqe->user_data;
+		uint32_t slot = (uint32_t) (cqe->user_data >> 8);
+		switch (op) {
+		case OP_ACCEPT:
+			onAccept(cqe);
+			break;
+		case OP_RECV:
+			onRecv(slot, cqe);
+			break;
+		case OP_SEND:
+			onSend(slot, cqe);
+			break;
+		case OP_CLOSE:
+			onClose(slot, cqe);
+			break;
+		case OP_SHUTDOWN:
+			KeepRunning = false;
+			break;
+		}
+		Ring.seen();
+	}
+	//hands every buffer recycled in this batch back at once
+	if (UseBufferRing) {
+		__atomic_store_n(&BufferRing->tail, BufferTail, __ATOMIC_RELEASE);
+	}
+}
+
+//Cancels everything still in flight, again and again until the kernel finds nothing left: ops already running
+//can't be cancelled and have to be waited out. Completions are thrown away. False if the ring stops working first
+bool UringServer::cancelAll() {
+	for (;;) {
+		io_uring_sqe *sqe = getSqe(OP_CANCEL_ALL, 0);
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+		bool done = false;
+		int res = 0;
+		while (!done) {
+			int err = Ring.submitAndWait(-1);
+			if (err < 0 && err != -EINTR && err != -EAGAIN && err != -EBUSY) {
+				return false;
+			}
+			io_uring_cqe *cqe;
+			while ((cqe = Ring.peek()) != 0) {
+				if ((uint8_t) cqe->user_data == OP_CANCEL_ALL) {
+					done = true;
+					res = cqe->res;
+				}
+				Ring.seen();
+			}
+		}
+		//how many it found, running ones included
+		if (res == 0 || res == -ENOENT) {
+			return true;
+		}
+		if (res < 0) {
+			return false;
+		}
+	}
+}
+
+int UringServer::getWaitMs() const {
+	return AcceptPaused ? ACCEPT_RETRY_MS : getTimeout();
+}
+
+void UringServer::run() {
+	while (KeepRunning) {
+		if (AcceptPaused && Now >= AcceptRetryAt) {
+			AcceptPaused = false;
+			armAccept();
+		}
+		//noise used by the last batch is made up while nothing is waiting on it
+		Noise.refill();
+		int err = Ring.submitAndWait(getWaitMs());
+		updateNow();
+		if (err < 0 && err != -ETIME && err != -EINTR && err != -EAGAIN && err != -EBUSY) {
+			errno = -err;
+			perror("io_uring_enter");
+			return;
+		}
+		reap();
+		runTimeouts();
+	}
+	//whoever solved it is owed the success message
+	uint64_t until = Now + SHUTDOWN_FLUSH_MS;
+	while (NumClosing > 0 && Now < until) {
+		Ring.submitAndWait((int) (until - Now));
+		updateNow();
+		reap();
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef URING_SERVER_H
+#define URING_SERVER_H
+
+#include "Server.h"
+#include "Uring.h"
+
+//io_uring backend. Nothing here makes a system call per connection: one multishot accept brings in every new
+//session, one multishot recv per session keeps delivering its data into buffers the kernel picks from a ring we
+//share with it (or where buffer rings don't work, that are provided one at a time), replies go out as SENDMSG and
+//a session ends with its last reply linked to its CLOSE. The loop's only syscall is the io_uring_enter that
+//submits all of that and waits for the next completion or timeout.
+//init fails, and main falls back to epoll, on kernels that are missing any of it.
+class UringServer: public Server {
+public:
+	static const uint32_t SQ_ENTRIES = 1024;
+	//multishot ops post many completions for one submission
+	static const uint32_t CQ_ENTRIES = 8 * SQ_ENTRIES;
+	//receive buffers each fit in an empty Input, so a completion is always copied whole
+	static const uint32_t RECV_BUFFER_SIZE = ClientInfo::INPUT_SIZE;
+	//power of two
+	static const uint32_t NUM_RECV_BUFFERS = 1024;
+	//how long a solved session's last message gets to go out after shutdown
+	static const int SHUTDOWN_FLUSH_MS = 1000;
+public:
+	UringServer(int listenFD, int shutdownFD, uint32_t maxClients, LogRing *log, WorkerMetrics *metrics);
+	virtual ~UringServer();
+	virtual bool init();
+	virtual void run();
+protected:
+	virtual void drop(ClientInfo *c);
+private:
+	//what a session has in flight, and how far along closing it is
+	struct Slot {
+		uint8_t InFlight;
+		bool Closing;
+		//a timeout or an error, don't bother sending what's left
+		bool Abort;
+		bool CloseQueued;
+		//the SENDMSG in flight points here
+		msghdr Msg;
+		iovec Iov[ClientInfo::MAX_OUT_SEGMENTS];
+	};
+	enum Op {
+		OP_ACCEPT, OP_RECV, OP_SEND, OP_CLOSE, OP_CANCEL, OP_SHUTDOWN, OP_PROVIDE, OP_CHECK, OP_CANCEL_ALL
+	};
+	io_uring_sqe *getSqe(uint8_t op, uint32_t slot);
+	void armAccept();
+	void armShutdown();
+	void armRecv(uint32_t slot, int fd);
+	void send(uint32_t slot, ClientInfo *c, bool link);
+	void cancel(uint32_t slot, uint8_t op);
+	void queueClose(uint32_t slot, ClientInfo *c);
+	void finish(uint32_t slot, ClientInfo *c);
+	void advanceClose(uint32_t slot, ClientInfo *c);
+	void afterIO(uint32_t slot, ClientInfo *c);
+	void onAccept(const io_uring_cqe *cqe);
+	void onRecv(uint32_t slot, const io_uring_cqe *cqe);
+	void onSend(uint32_t slot, const io_uring_cqe *cqe);
+	void onClose(uint32_t slot, const io_uring_cqe *cqe);
+	bool setupBuffers();
+	bool checkBuffers(uint16_t group);
+	void recycleBuffer(uint16_t id);
+	void reap();
+	bool cancelAll();
+	int getWaitMs() const;
+private:
+	Uring Ring;
+	Slot *Slots;
+	//NUM_RECV_BUFFERS buffers of RECV_BUFFER_SIZE and the ring the kernel takes them from, or if the kernel's
+	//buffer rings don't work the group they are handed back to one PROVIDE_BUFFERS at a time
+	char *RecvBuffers;
+	io_uring_buf_ring *BufferRing;
+	size_t BufferRingSize;
+	uint16_t BufferTail;
+	bool UseBufferRing;
+	uint16_t BufferGroup;
+	bool AcceptPaused;
+	uint64_t AcceptRetryAt;
+	//sessions between finish and their slot coming back
+	uint32_t NumClosing;
+};
+
+#endif
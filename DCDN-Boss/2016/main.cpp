@@ -4,110 +4,47 @@
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
-#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
 #include <arpa/inet.h>
-#include <fcntl.h> /* Added for the nonblocking socket */
-#include <time.h>
-#include <list>
+#include <getopt.h>
+#include <pthread.h>
 #include <unistd.h>
-#include <string>
 #include <cstring>
+#include <vector>
+#include "EpollServer.h"
+#include "UringServer.h"
 
 #define MYPORT 3456    /* the port users will be connecting to */
-#define BACKLOG 10     /* how many pending connections queue will hold */
-
-static const int MAX_TIME_BETWEEN_DATA = 120;
-static const int MAX_TIME_FOR_CONNECTION = MAX_TIME_BETWEEN_DATA * 4;
-
-static const char *CYBEREZ[64][7] = { "Cyberez Inc.", "Cyb3r3z 1nc.", "cYber3z", "debug: ok",
-		"error: memory invalid", "success", "jack of spades initialized" };
-
-static const char *HEX_STRING = "0123456789ABCDEF";
-
-void generateRandomShit(char *p, unsigned int n) {
-	bool addCyberez = ((rand() % 100) < 25 ? true : false);
-	int where = -1;
-	if (addCyberez) {
-		int loc = rand() % 3;
-		switch (loc) {
-		case 1:
-			where = 0;
-			break;
-		case 2:
-			where = n / 2;
-			break;
-		case 3:
-			where = n - 32;
-			break;
-		default:
-			break;
-		}
+#define BACKLOG SOMAXCONN     /* how many pending connections queue will hold, the kernel caps it at net.core.somaxconn */
+#define DEFAULT_MAX_CLIENTS 16384 /* sessions across all workers, each worker preallocates its share */
+
+//one fd per session, the default soft limit of 1024 would stop us well short of 10k
+//returns the limit we ended up with
+static rlim_t raiseFileLimit() {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+		return 1024;
 	}
-	for (unsigned int i = 0; i < n - 1; i++) {
-		if (i == where) {
-			int which = rand() % 7;
-			strncpy(&p[i], CYBEREZ[0][which], strlen(CYBEREZ[0][which]));
-			i += strlen(CYBEREZ[0][which]);
-		} else {
-			p[i] = HEX_STRING[rand() % 16];
+	if (rl.rlim_cur < rl.rlim_max) {
+		rlim_t wanted = rl.rlim_max;
+		rl.rlim_cur = wanted;
+		if (setrlimit(RLIMIT_NOFILE, &rl) == 0) {
+			return wanted;
 		}
+		getrlimit(RLIMIT_NOFILE, &rl);
 	}
-	p[n] = '\0';
+	return rl.rlim_cur;
 }
 
-struct ClientInfo {
-	int FD;
-	int RightAnswers;
-	time_t ConnectTime;
-	time_t LastDataReceived;
-	std::string InputBuffer;
-	std::string OutputBuffer;
-	bool Dead;
-	void bufferIn() {
-		char buf[256];
-		int n = recv(FD, &buf[0], sizeof(buf), 0);
-		if (n > 0) {
-			InputBuffer.append(&buf[0], n);
-			LastDataReceived = time(0);
-		} else {
-			if (n == 0 || (n < 0 && errno != EAGAIN)) {
-				Dead = true;
-			}
-		}
-	}
-	void bufferOut(const char *b, int n) {
-		OutputBuffer.append(b, n);
-	}
-	void sendAll() {
-		if (OutputBuffer.length() > 0) {
-			int n = 0;
-			while (OutputBuffer.length() > 0 && (n = send(FD, OutputBuffer.data(), OutputBuffer.length(), 0)) > 0) {
-				OutputBuffer = OutputBuffer.substr(n);
-			}
-			if (n == 0 || (n == -1 && errno != EAGAIN)) {
-				Dead = true;
-			}
-		}
-	}
-	ClientInfo(int fd) :
-			FD(fd), RightAnswers(0), ConnectTime(time(0)), LastDataReceived(time(0)), InputBuffer(), OutputBuffer(), Dead(
-					false) {
-	}
-	~ClientInfo() {
-		close(FD);
-	}
-};
-
-int main(int arc, char *agrv[]) {
-	srand(time(0));
-	int sockfd = 0, new_fd = 0; /* listen on sock_fd, new connection on new_fd */
+//every worker binds its own socket to the port, SO_REUSEPORT has the kernel spread new connections across them
+static int openListener() {
+	int sockfd = 0; /* listen on sock_fd */
 	struct sockaddr_in my_addr; /* my address information */
-	struct sockaddr_in their_addr; /* connector's address information */
-	unsigned int sin_size;
 
-	if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+	if ((sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
 		perror("socket");
-		exit(1);
+		return -1;
 	}
 
 	my_addr.sin_family = AF_INET; /* host byte order */
@@ -115,85 +52,168 @@ int main(int arc, char *agrv[]) {
 	my_addr.sin_addr.s_addr = INADDR_ANY; /* auto-fill with my IP */
 	bzero(&(my_addr.sin_zero), 8); /* zero the rest of the struct */
 
-	fcntl(sockfd, F_SETFL, O_NONBLOCK); /* Change the socket into non-blocking state	*/
 	int optval = 1;
 	setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
 	if (bind(sockfd, (struct sockaddr *) &my_addr, sizeof(struct sockaddr)) == -1) {
 		perror("bind");
-		exit(1);
+		close(sockfd);
+		return -1;
 	}
 
 	if (listen(sockfd, BACKLOG) == -1) {
 		perror("listen");
-		exit(1);
+		close(sockfd);
+		return -1;
 	}
+	return sockfd;
+}
 
-	typedef std::list<ClientInfo *> CLIENT_LIST;
-	typedef std::list<ClientInfo *>::iterator CLIENT_LIST_IT;
-
-	CLIENT_LIST ListOfSockets;
-
-	char Results[7][20] = { "MONA", "XfjnhD0ZQ8", "5zQXLfSo71", "E2ElmnWDuv", "MY8VBVunA6", "ZWxEcrPWc0", "4OmUw7DuEo" };
-	char Prompt[7][20] = { "#connection\n", "#datadown\n", "#dataup\n", "#keygen\n", "#10/6\n", "#initiate\n" };
+struct Worker {
+	int ListenFD;
+	int ShutdownFD;
+	uint32_t MaxClients;
+	LogRing *Log;
+	WorkerMetrics *Stats;
+	bool UseUring;
+	pthread_t Thread;
+};
 
-	bool keepRunning = true;
-	while (keepRunning) {
-		sin_size = sizeof(struct sockaddr_in);
-		if ((new_fd = accept(sockfd, (struct sockaddr *) &their_addr, &sin_size)) != -1) {
-			fcntl(new_fd, F_SETFL, O_NONBLOCK);
-			printf("server: got connection from %s\n", inet_ntoa(their_addr.sin_addr));
-			ListOfSockets.push_back(new ClientInfo(new_fd));
+static void *workerMain(void *p) {
+	Worker *w = (Worker *) p;
+	Server *server = 0;
+	if (w->UseUring) {
+		server = new UringServer(w->ListenFD, w->ShutdownFD, w->MaxClients, w->Log, w->Stats);
+		if (!server->init()) {
+			printf("io_uring not available, falling back to epoll\n");
+			delete server;
+			server = 0;
 		}
-		std::list<CLIENT_LIST_IT> removeList;
-		CLIENT_LIST_IT it;
-		for (it = ListOfSockets.begin(); it != ListOfSockets.end(); ++it) {
-			if (!(*it)->Dead) {
-				(*it)->bufferIn();
+	}
+	if (!server) {
+		server = new EpollServer(w->ListenFD, w->ShutdownFD, w->MaxClients, w->Log, w->Stats);
+		if (!server->init()) {
+			delete server;
+			return 0;
+		}
+	}
+	server->run();
+	delete server;
+	return 0;
+}
 
-				if ((*it)->InputBuffer.length() > 1) {
-					if (strncmp(Results[(*it)->RightAnswers], (*it)->InputBuffer.data(),
-							strlen(Results[(*it)->RightAnswers])) == 0) {
-						(*it)->InputBuffer.clear();
-						if ((*it)->RightAnswers == 6) {
-							static const char *success = "March Hare daemon initialized.\nConnection Terminated";
-							send((*it)->FD, success, strlen(success), 0);
-							keepRunning = false;
-						} else {
-							//send((*it)->FD, Prompt[(*it)->RightAnswers], strlen(Prompt[(*it)->RightAnswers]), 0);
-							(*it)->bufferOut(Prompt[(*it)->RightAnswers], strlen(Prompt[(*it)->RightAnswers]));
-							(*it)->RightAnswers++;
-							char buf[128];
-							generateRandomShit(&buf[0], sizeof(buf));
-							(*it)->bufferOut(buf, 128);
-						}
-					} else {
-						printf("Wrong answer sent by connection: %s", inet_ntoa(their_addr.sin_addr));
-						const char *message = "Incorrect code.\nConnection closed.";
-						(*it)->bufferOut(message, strlen(message));
-						(*it)->Dead = true;
-					}
-				} else {
-					if (time(0) - (*it)->LastDataReceived > MAX_TIME_BETWEEN_DATA) {
-						printf("%s too much time between data", inet_ntoa(their_addr.sin_addr));
-						(*it)->Dead = true;
-					}
-					if (time(0) - (*it)->ConnectTime > MAX_TIME_FOR_CONNECTION) {
-						printf("%s was connected for too long", inet_ntoa(their_addr.sin_addr));
-						(*it)->Dead = true;
-					}
-				}
-				(*it)->sendAll();
-			} else {
-				removeList.push_back(it);
+static void usage() {
+	printf("BossServer --workers <event loop threads, each with its own listen socket, 0 = one per core>\n");
+	printf("           --max-clients <sessions across all workers, default %d>\n", DEFAULT_MAX_CLIENTS);
+	printf("           --metrics <UNIX socket path to serve counters and latency histograms on, Prometheus text>\n");
+	printf("           --backend <epoll (default) or uring, uring falls back to epoll if the kernel can't do it>\n");
+}
+
+int main(int argc, char *argv[]) {
+	rlim_t fileLimit = raiseFileLimit();
+
+	int numWorkers = 1;
+	long maxClients = DEFAULT_MAX_CLIENTS;
+	const char *metricsPath = 0;
+	bool useUring = false;
+	static const struct option LONG_OPTIONS[] = { { "workers", required_argument, 0, 'w' }, { "max-clients",
+			required_argument, 0, 'c' }, { "metrics", required_argument, 0, 'm' }, { "backend", required_argument, 0,
+			'b' }, { 0, 0, 0, 0 } };
+	int ch;
+	while ((ch = getopt_long(argc, argv, "w:c:m:b:", LONG_OPTIONS, 0)) != -1) {
+		switch (ch) {
+		case 'w':
+			numWorkers = atoi(optarg);
+			if (numWorkers < 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case 'c':
+			maxClients = atol(optarg);
+			if (maxClients <= 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case 'm':
+			metricsPath = optarg;
+			break;
+		case 'b':
+			if (strcmp(optarg, "uring") == 0) {
+				useUring = true;
+			} else if (strcmp(optarg, "epoll") != 0) {
+				usage();
+				return 1;
 			}
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (numWorkers == 0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		numWorkers = n > 0 ? (int) n : 1;
+	}
+	//leave room for the listen sockets, epoll or io_uring and stdio
+	if ((rlim_t) maxClients + 16 + 2 * numWorkers > fileLimit) {
+		maxClients = fileLimit > (rlim_t) (16 + 2 * numWorkers) ? (long) (fileLimit - 16 - 2 * numWorkers) : 1;
+		printf("open file limit is %lu, capping sessions at %ld\n", (unsigned long) fileLimit, maxClients);
+	}
+	uint32_t perWorker = (uint32_t) ((maxClients + numWorkers - 1) / numWorkers);
+	size_t slab = (size_t) perWorker * ClientPool::getBytesPerClient();
+	printf("client pool: %u sessions x %lu bytes per worker, %.1f MB each, %.1f MB total\n", perWorker,
+			(unsigned long) ClientPool::getBytesPerClient(), slab / 1048576.0, slab * numWorkers / 1048576.0);
+
+	//whoever initializes the daemon makes this readable, every worker's loop sees it and stops
+	int shutdownFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (shutdownFD < 0) {
+		perror("eventfd");
+		exit(1);
+	}
+	//connects, drops and timeouts are written out from here, the workers only queue records
+	AsyncLog log(stdout);
+	Metrics metrics;
+	//all sockets up front so a bind failure stops us before anything runs
+	std::vector<Worker> workers(numWorkers);
+	for (int i = 0; i < numWorkers; i++) {
+		workers[i].ListenFD = openListener();
+		workers[i].ShutdownFD = shutdownFD;
+		workers[i].MaxClients = perWorker;
+		workers[i].Log = log.createRing();
+		workers[i].Stats = metrics.createWorker();
+		workers[i].UseUring = useUring;
+		if (workers[i].ListenFD < 0) {
+			exit(1);
+		}
+	}
+	if (metricsPath) {
+		if (!metrics.start(metricsPath)) {
+			exit(1);
 		}
-		//ListOfSockets.erase(removeList.begin(), removeList.end());
-		for (std::list<CLIENT_LIST_IT>::iterator rit = removeList.begin(); rit != removeList.end(); ++rit) {
-			ListOfSockets.erase(*rit);
-			printf("dropping connection");
-			delete (*(*rit));
+		printf("metrics on %s\n", metricsPath);
+	}
+	fflush(stdout);
+	if (!log.start()) {
+		exit(1);
+	}
+	//worker 0 runs on the main thread
+	int started = 1;
+	for (; started < numWorkers; started++) {
+		if (pthread_create(&workers[started].Thread, 0, workerMain, &workers[started]) != 0) {
+			perror("pthread_create");
+			break;
 		}
-		usleep(50);
 	}
+	workerMain(&workers[0]);
+	for (int i = 1; i < started; i++) {
+		pthread_join(workers[i].Thread, 0);
+	}
+	metrics.stop();
+	log.stop();
+	for (int i = 0; i < numWorkers; i++) {
+		close(workers[i].ListenFD);
+	}
+	close(shutdownFD);
+	return 0;
 }
-
@@ -1,4 +1,5 @@
 #include "EnigmaState.h"
+#include <enigma.h>
 
 ////////////////////////////////////////////////////////////
 EngimaState::EngimaState() :
@@ -59,7 +60,9 @@ ReturnStateContext EngimaState::onRun(QKeyboard &kb) {
 		if (kb.getLastKeyReleased() == 11) {
 			InternalState = DECRYPT;
 			getKeyboardContext().finalize();
-			crypt(&Wheels[0], &PlugBoard[0], strlen(&PlugBoard[0]), &EntryBuffer[0]);
+			Enigma enigma;
+			enigma.setKey(&Wheels[0], &PlugBoard[0], strlen(&PlugBoard[0]));
+			enigma.crypt(&EntryBuffer[0], &EncryptResult[0], sizeof(EncryptResult));
 			DisplayOffset = 0;
 			LastScrollTime = HAL_GetTick();
 		} else if (kb.getLastKeyReleased() == 9) {
@@ -103,102 +106,6 @@ ReturnStateContext EngimaState::onRun(QKeyboard &kb) {
 	return ReturnStateContext(nextState);
 }
 
-const char alpha[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-static const uint32_t NUM_ROTORS = 13;
-const char rotors[NUM_ROTORS][27] = { "DVOARQWTUZJCNFLSPMBHEYIGKX", "GHQZUJFWLVMTKOPIRSDEACXYBN",
-		"AKUOCLVJYIXMQPERBWSNGFZHTD", "BKLOSUDPJIRHZEXCGQMNVYFATW", "LICFJPORWQVHANKEBUDYMGZXTS",
-		"CAWFYLKXSZTGHPINMDREUQBJVO", "PYVREUXHKIWDNQAZTLSMBOJGFC", "LQRHNSTPAFIVJYMDGUOZKECWXB",
-		"JAUMCWHXTIZDYORQNSKBEFGLPV", "VRKNGZQOUXTMDIECJYPFSAWBLH", "LUHMZRVEGYSPJFADQCWTKBNXIO",
-		"SDIJUOBALVMYRNGWKHPQCXTFZE", "LIVPNYCUGSRFBXKQHMOEWZTDAJ" };
-
-long EngimaState::mod26(long a) {
-	return (a % 26 + 26) % 26;
-}
-
-int EngimaState::li(char l) {
-// Letter index
-	return l - 'A';
-}
-
-int EngimaState::indexof(const char* array, int find) {
-	return strchr(array, find) - array;
-}
-
-void EngimaState::doPlug(char *r, const char *swapChars, int s) {
-	for (int l = 0; l < s; l += 2) {
-		int first = strchr(r, swapChars[l]) - r;
-		if (first < 0)
-			first = 0;
-		int second = strchr(r, swapChars[l + 1]) - r;
-		if (second < 0)
-			second = 0;
-		char tmp = r[first];
-		r[first] = r[second];
-		r[second] = tmp;
-	}
-}
-
-int islower(int __c) {
-	return __c >= 'a' && __c <= 'z';
-}
-
-int toupper(int __c) {
-	return islower(__c) ? (__c & ~32) : __c;
-}
-
-const char* EngimaState::crypt(char *Wheels, const char *plugBoard, int plugBoardSize, const char *ct) {
-	static const char reflector[] = "YRUHQSLDPXNGOKMIEBFZCWVJAT";
-// Sets initial permutation
-	int L = li(toupper(Wheels[1]));
-	int M = li(toupper(Wheels[3]));
-	int R = li(toupper(Wheels[5]));
-
-	memset(&EncryptResult[0], 0, sizeof(EncryptResult));
-	char *outPtr = &EncryptResult[0];
-
-	int rotorIdx0 = li(toupper(Wheels[0])) % NUM_ROTORS;
-	int rotorIdx1 = li(toupper(Wheels[2])) % NUM_ROTORS;
-	int rotorIdx2 = li(toupper(Wheels[4])) % NUM_ROTORS;
-
-	char r0[27] = { '\0' };
-	strcpy(&r0[0], rotors[rotorIdx0]);
-	doPlug(&r0[0], plugBoard, plugBoardSize);
-	char r1[27] = { '\0' };
-	strcpy(&r1[0], rotors[rotorIdx1]);
-	doPlug(&r1[0], plugBoard, plugBoardSize);
-	char r2[27] = { '\0' };
-	strcpy(&r2[0], rotors[rotorIdx2]);
-	doPlug(&r2[0], plugBoard, plugBoardSize);
-
-	for (uint16_t x = 0; x < strlen(ct) && x < sizeof(EncryptResult); x++) {
-		if (ct[x] == ' ')
-			continue;
-
-		int ct_letter = li(toupper(ct[x]));
-
-		// Step right rotor on every iteration
-		R = mod26(R + 1);
-
-		// Pass through rotors
-		char a = r2[mod26(R + ct_letter)];
-		char b = r1[mod26(M + li(a) - R)];
-		char c = r0[mod26(L + li(b) - M)];
-
-		// Pass through reflector
-		char ref = reflector[mod26(li(c) - L)];
-
-		// Inverse rotor pass
-		int d = mod26(indexof(&r0[0], alpha[mod26(li(ref) + L)]) - L);
-		int e = mod26(indexof(&r1[0], alpha[mod26(d + M)]) - M);
-		char f = alpha[mod26(indexof(&r2[0], alpha[mod26(e + R)]) - R)];
-
-		*outPtr = f;
-		outPtr++;
-	}
-
-	return &EncryptResult[0];
-}
-
 ErrorType EngimaState::onShutdown() {
 	return ErrorType();
 }
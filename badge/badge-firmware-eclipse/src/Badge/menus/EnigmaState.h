@@ -15,12 +15,6 @@ protected:
 	virtual ErrorType onInit();
 	virtual ReturnStateContext onRun(QKeyboard &kb);
 	virtual ErrorType onShutdown();
-protected:
-	long mod26(long a);
-	int li(char l);
-	int indexof (const char* array, int find);
-	const char* crypt(char *Wheels, const char *plugBoard, int plugBoardSize, const char *ct);
-	void doPlug(char *r, const char *swapChars, int s);
 private:
 	static const uint16_t MAX_ENCRYPTED_LENGTH = 200;
 	INTERNAL_STATE InternalState;
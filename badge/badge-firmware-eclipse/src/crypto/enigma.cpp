@@ -0,0 +1,86 @@
+#include "enigma.h"
+
+static const char ROTORS[Enigma::NUM_ROTORS][Enigma::NUM_LETTERS + 1] = { "DVOARQWTUZJCNFLSPMBHEYIGKX",
+		"GHQZUJFWLVMTKOPIRSDEACXYBN", "AKUOCLVJYIXMQPERBWSNGFZHTD", "BKLOSUDPJIRHZEXCGQMNVYFATW",
+		"LICFJPORWQVHANKEBUDYMGZXTS", "CAWFYLKXSZTGHPINMDREUQBJVO", "PYVREUXHKIWDNQAZTLSMBOJGFC",
+		"LQRHNSTPAFIVJYMDGUOZKECWXB", "JAUMCWHXTIZDYORQNSKBEFGLPV", "VRKNGZQOUXTMDIECJYPFSAWBLH",
+		"LUHMZRVEGYSPJFADQCWTKBNXIO", "SDIJUOBALVMYRNGWKHPQCXTFZE", "LIVPNYCUGSRFBXKQHMOEWZTDAJ" };
+static const char REFLECTOR[] = "YRUHQSLDPXNGOKMIEBFZCWVJAT";
+
+//a in [-26, 52)
+static uint8_t wrap(int a) {
+	return a < 0 ? a + Enigma::NUM_LETTERS : (a >= (int) Enigma::NUM_LETTERS ? a - Enigma::NUM_LETTERS : a);
+}
+
+static bool isSpace(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+//where the plug board letter sits in the wiring, a char the wiring doesn't have is position 0
+static uint8_t plugPosition(const uint8_t *inverse, char c) {
+	return c >= 'A' && c <= 'Z' ? inverse[c - 'A'] : 0;
+}
+
+static void loadRotor(uint8_t *forward, uint8_t *inverse, char rotor, const char *plugBoard, int plugBoardSize) {
+	const char *wiring = ROTORS[Enigma::letterIndex(rotor) % Enigma::NUM_ROTORS];
+	for (uint8_t i = 0; i < Enigma::NUM_LETTERS; i++) {
+		forward[i] = wiring[i] - 'A';
+		inverse[forward[i]] = i;
+	}
+	//each pair swaps the two letters' positions in the wiring
+	for (int l = 0; l + 1 < plugBoardSize; l += 2) {
+		uint8_t first = plugPosition(inverse, plugBoard[l]);
+		uint8_t second = plugPosition(inverse, plugBoard[l + 1]);
+		uint8_t tmp = forward[first];
+		forward[first] = forward[second];
+		forward[second] = tmp;
+		inverse[forward[first]] = first;
+		inverse[forward[second]] = second;
+	}
+}
+
+uint8_t Enigma::letterIndex(char c) {
+	int l = (c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c) - 'A';
+	return l >= 0 && l < (int) NUM_LETTERS ? l : (l % (int) NUM_LETTERS + NUM_LETTERS) % NUM_LETTERS;
+}
+
+Enigma::Enigma() :
+		RightForward(), RightInverse(), Middle(), RightStart(0) {
+}
+
+void Enigma::setKey(const char *wheels, const char *plugBoard, int plugBoardSize) {
+	uint8_t leftForward[NUM_LETTERS], leftInverse[NUM_LETTERS];
+	uint8_t middleForward[NUM_LETTERS], middleInverse[NUM_LETTERS];
+	loadRotor(&leftForward[0], &leftInverse[0], wheels[0], plugBoard, plugBoardSize);
+	loadRotor(&middleForward[0], &middleInverse[0], wheels[2], plugBoard, plugBoardSize);
+	loadRotor(&RightForward[0], &RightInverse[0], wheels[4], plugBoard, plugBoardSize);
+	int L = letterIndex(wheels[1]);
+	int M = letterIndex(wheels[3]);
+	RightStart = letterIndex(wheels[5]);
+
+	//middle and left rotor, reflector and back, none of which move
+	for (int a = 0; a < (int) NUM_LETTERS; a++) {
+		int b = middleForward[wrap(M + a)];
+		int c = leftForward[wrap(L + b - M)];
+		int ref = REFLECTOR[wrap(c - L)] - 'A';
+		int d = wrap(leftInverse[wrap(ref + L)] - L);
+		Middle[a] = wrap(middleInverse[wrap(d + M)] - M);
+	}
+}
+
+uint32_t Enigma::crypt(const char *in, char *out, uint32_t outSize) const {
+	uint32_t n = 0;
+	uint8_t r = RightStart;
+	for (; *in != '\0' && n + 1 < outSize; in++) {
+		if (isSpace(*in)) {
+			continue;
+		}
+		//right rotor steps before every letter
+		r = r == NUM_LETTERS - 1 ? 0 : r + 1;
+		out[n++] = 'A' + step(r, letterIndex(*in));
+	}
+	if (outSize > 0) {
+		out[n] = '\0';
+	}
+	return n;
+}
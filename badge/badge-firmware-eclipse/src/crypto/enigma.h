@@ -0,0 +1,43 @@
+#ifndef ENIGMA_H
+#define ENIGMA_H
+
+#include <stdint.h>
+
+//The three rotor machine behind the badge's Enigma quest and BadgeGen -w/-p/-m.
+//Same file in BadgeGen/src and the badge's src/crypto, keep the two in sync.
+//
+//wheels is 6 chars, rotor then start position for the left, middle and right rotor ("ACEGIK").
+//A rotor letter picks one of the 13 wirings (A and N are the same one), plugBoard swaps letter pairs in every rotor.
+//Only the right rotor steps, once per letter, so with the key set the left rotor, middle rotor and reflector
+//collapse into one fixed permutation; setKey builds it with the right rotor's forward and inverse wiring
+//and a letter costs four table lookups.
+class Enigma {
+public:
+	static const uint32_t NUM_ROTORS = 13;
+	static const uint32_t NUM_LETTERS = 26;
+public:
+	Enigma();
+	//has to be called before crypt, plugBoardSize is rounded down to whole pairs
+	void setKey(const char *wheels, const char *plugBoard, int plugBoardSize);
+	//runs the letters of in through the machine into out, whitespace is skipped and out is always terminated,
+	//returns the number of letters written. The machine is its own inverse so this encrypts and decrypts.
+	uint32_t crypt(const char *in, char *out, uint32_t outSize) const;
+	//output letter (0-25) for letter with the right rotor at rightPos (0-25)
+	uint8_t step(uint8_t rightPos, uint8_t letter) const {
+		uint8_t i = rightPos + letter;
+		int8_t a = RightForward[i >= NUM_LETTERS ? i - NUM_LETTERS : i] - rightPos;
+		i = Middle[a < 0 ? a + NUM_LETTERS : a] + rightPos;
+		int8_t f = RightInverse[i >= NUM_LETTERS ? i - NUM_LETTERS : i] - rightPos;
+		return f < 0 ? f + NUM_LETTERS : f;
+	}
+	//0-25 for any char the way the original mod 26 arithmetic saw it, 'A'/'a' = 0
+	static uint8_t letterIndex(char c);
+private:
+	uint8_t RightForward[NUM_LETTERS];
+	uint8_t RightInverse[NUM_LETTERS];
+	//right rotor output, relative to its position, to the letter coming back into it
+	uint8_t Middle[NUM_LETTERS];
+	uint8_t RightStart;
+};
+
+#endif
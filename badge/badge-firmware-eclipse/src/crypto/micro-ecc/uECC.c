@@ -181,6 +181,10 @@ static cmpresult_t uECC_vli_cmp_unsafe(const uECC_word_t *left,
     #include "asm_avr.inc"
 #endif
 
+#if (uECC_PLATFORM == uECC_x86_64) && (uECC_WORD_SIZE == 8) && uECC_X86_64_USE_ASM
+    #include "asm_x86_64.inc"
+#endif
+
 #if default_RNG_defined
 static uECC_RNG_Function g_rng_function = &default_RNG;
 #else
@@ -363,7 +367,7 @@ uECC_VLI_API uECC_word_t uECC_vli_sub(uECC_word_t *result,
 }
 #endif /* !asm_sub */
 
-#if !asm_mult || (uECC_SQUARE_FUNC && !asm_square) || \
+#if !asm_mult || asm_mult_fallback || (uECC_SQUARE_FUNC && (!asm_square || asm_square_fallback)) || \
     (uECC_SUPPORTS_secp256k1 && (uECC_OPTIMIZATION_LEVEL > 0) && \
         ((uECC_WORD_SIZE == 1) || (uECC_WORD_SIZE == 8)))
 static void muladd(uECC_word_t a,
@@ -407,11 +411,20 @@ static void muladd(uECC_word_t a,
 }
 #endif /* muladd needed */
 
-#if !asm_mult
+#if !asm_mult || asm_mult_fallback
+/* With asm_mult_fallback the assembly uECC_vli_mult() calls this for the sizes or CPUs it does
+   not handle. */
+#if asm_mult_fallback
+static void vli_mult_c(uECC_word_t *result,
+                       const uECC_word_t *left,
+                       const uECC_word_t *right,
+                       wordcount_t num_words) {
+#else
 uECC_VLI_API void uECC_vli_mult(uECC_word_t *result,
                                 const uECC_word_t *left,
                                 const uECC_word_t *right,
                                 wordcount_t num_words) {
+#endif
     uECC_word_t r0 = 0;
     uECC_word_t r1 = 0;
     uECC_word_t r2 = 0;
@@ -438,11 +451,11 @@ uECC_VLI_API void uECC_vli_mult(uECC_word_t *result,
     }
     result[num_words * 2 - 1] = r0;
 }
-#endif /* !asm_mult */
+#endif /* !asm_mult || asm_mult_fallback */
 
 #if uECC_SQUARE_FUNC
 
-#if !asm_square
+#if !asm_square || asm_square_fallback
 static void mul2add(uECC_word_t a,
                     uECC_word_t b,
                     uECC_word_t *r0,
@@ -490,9 +503,13 @@ static void mul2add(uECC_word_t a,
 #endif
 }
 
+#if asm_square_fallback
+static void vli_square_c(uECC_word_t *result, const uECC_word_t *left, wordcount_t num_words) {
+#else
 uECC_VLI_API void uECC_vli_square(uECC_word_t *result,
                                   const uECC_word_t *left,
                                   wordcount_t num_words) {
+#endif
     uECC_word_t r0 = 0;
     uECC_word_t r1 = 0;
     uECC_word_t r2 = 0;
@@ -516,7 +533,7 @@ uECC_VLI_API void uECC_vli_square(uECC_word_t *result,
 
     result[num_words * 2 - 1] = r0;
 }
-#endif /* !asm_square */
+#endif /* !asm_square || asm_square_fallback */
 
 #else /* uECC_SQUARE_FUNC */
 
@@ -853,17 +870,25 @@ static void XYcZ_addC(uECC_word_t * X1,
     uECC_vli_set(X1, t7, num_words);
 }
 
-/* result may overlap point. */
-static void EccPoint_mult(uECC_word_t * result,
-                          const uECC_word_t * point,
-                          const uECC_word_t * scalar,
-                          const uECC_word_t * initial_Z,
-                          bitcount_t num_bits,
-                          uECC_Curve curve) {
-    /* R0 and R1 */
+/* Ladder state between the scalar loop and the final affine conversion. */
+typedef struct {
     uECC_word_t Rx[2][uECC_MAX_WORDS];
     uECC_word_t Ry[2][uECC_MAX_WORDS];
     uECC_word_t z[uECC_MAX_WORDS];
+    uECC_word_t nb;
+    uECC_word_t comb; /* Rx[0], Ry[0], z hold a Jacobian point from the fixed-base comb instead */
+} EccPoint_ladder;
+
+/* Runs the co-Z ladder. On return ladder->z holds the value that must be inverted before
+   EccPoint_mult_finish(); it is zero if the result is the point at infinity. */
+static void EccPoint_mult_ladder(EccPoint_ladder *ladder,
+                                 const uECC_word_t * point,
+                                 const uECC_word_t * scalar,
+                                 const uECC_word_t * initial_Z,
+                                 bitcount_t num_bits,
+                                 uECC_Curve curve) {
+    uECC_word_t (*Rx)[uECC_MAX_WORDS] = ladder->Rx;
+    uECC_word_t (*Ry)[uECC_MAX_WORDS] = ladder->Ry;
     bitcount_t i;
     uECC_word_t nb;
     wordcount_t num_words = curve->num_words;
@@ -883,22 +908,315 @@ static void EccPoint_mult(uECC_word_t * result,
     XYcZ_addC(Rx[1 - nb], Ry[1 - nb], Rx[nb], Ry[nb], curve);
 
     /* Find final 1/Z value. */
-    uECC_vli_modSub(z, Rx[1], Rx[0], curve->p, num_words); /* X1 - X0 */
-    uECC_vli_modMult_fast(z, z, Ry[1 - nb], curve);               /* Yb * (X1 - X0) */
-    uECC_vli_modMult_fast(z, z, point, curve);                    /* xP * Yb * (X1 - X0) */
-    uECC_vli_modInv(z, z, curve->p, num_words);            /* 1 / (xP * Yb * (X1 - X0)) */
+    uECC_vli_modSub(ladder->z, Rx[1], Rx[0], curve->p, num_words); /* X1 - X0 */
+    uECC_vli_modMult_fast(ladder->z, ladder->z, Ry[1 - nb], curve);  /* Yb * (X1 - X0) */
+    uECC_vli_modMult_fast(ladder->z, ladder->z, point, curve);       /* xP * Yb * (X1 - X0) */
+    ladder->nb = nb;
+    ladder->comb = 0;
+}
+
+/* Expects ladder->z to hold 1 / (xP * Yb * (X1 - X0)). result may overlap point. */
+static void EccPoint_mult_finish(uECC_word_t * result,
+                                 EccPoint_ladder *ladder,
+                                 const uECC_word_t * point,
+                                 uECC_Curve curve) {
+    uECC_word_t (*Rx)[uECC_MAX_WORDS] = ladder->Rx;
+    uECC_word_t (*Ry)[uECC_MAX_WORDS] = ladder->Ry;
+    uECC_word_t nb = ladder->nb;
+    wordcount_t num_words = curve->num_words;
+
+    if (ladder->comb) {
+        /* z is already 1 / Z */
+        apply_z(Rx[0], Ry[0], ladder->z, curve);
+        uECC_vli_set(result, Rx[0], num_words);
+        uECC_vli_set(result + num_words, Ry[0], num_words);
+        return;
+    }
+
     /* yP / (xP * Yb * (X1 - X0)) */
-    uECC_vli_modMult_fast(z, z, point + num_words, curve);
-    uECC_vli_modMult_fast(z, z, Rx[1 - nb], curve); /* Xb * yP / (xP * Yb * (X1 - X0)) */
+    uECC_vli_modMult_fast(ladder->z, ladder->z, point + num_words, curve);
+    uECC_vli_modMult_fast(ladder->z, ladder->z, Rx[1 - nb], curve); /* Xb * yP / (xP * Yb * (X1 - X0)) */
     /* End 1/Z calculation */
 
     XYcZ_add(Rx[nb], Ry[nb], Rx[1 - nb], Ry[1 - nb], curve);
-    apply_z(Rx[0], Ry[0], z, curve);
+    apply_z(Rx[0], Ry[0], ladder->z, curve);
 
     uECC_vli_set(result, Rx[0], num_words);
     uECC_vli_set(result + num_words, Ry[0], num_words);
 }
 
+/* result may overlap point. */
+static void EccPoint_mult(uECC_word_t * result,
+                          const uECC_word_t * point,
+                          const uECC_word_t * scalar,
+                          const uECC_word_t * initial_Z,
+                          bitcount_t num_bits,
+                          uECC_Curve curve) {
+    EccPoint_ladder ladder;
+
+    EccPoint_mult_ladder(&ladder, point, scalar, initial_Z, num_bits, curve);
+    uECC_vli_modInv(ladder.z, ladder.z, curve->p, curve->num_words); /* 1 / (xP * Yb * (X1 - X0)) */
+    EccPoint_mult_finish(result, &ladder, point, curve);
+}
+
+#if uECC_SUPPORT_FIXED_BASE_COMB
+
+/* Fixed-base comb (Lim-Lee) for k * G. The scalar is cut into uECC_COMB_WIDTH rows of
+   comb_spacing() bits; column c of the rows indexes a table entry holding the matching sum of
+   2^(row * spacing) * G, so k * G takes spacing doublings and additions instead of a full ladder.
+   Entry j - 1 of the table is stored affine, 2 * num_words words per entry. Two more entries
+   follow: the offset Q = 2^(uECC_COMB_WIDTH * spacing) * G the comb starts from, so it never
+   passes through the point at infinity, and -2^spacing * Q, which takes it out again at the end. */
+#define uECC_COMB_POINTS ((1 << uECC_COMB_WIDTH) - 1)
+#define uECC_COMB_ENTRIES (uECC_COMB_POINTS + 2)
+
+#if uECC_COMB_CONST_TABLE
+    #if !uECC_SUPPORTS_secp192r1
+        #error "uECC_COMB_CONST_TABLE needs uECC_SUPPORTS_secp192r1"
+    #endif
+    #include "comb-secp192r1.inc"
+#else
+static uECC_word_t g_comb_table[uECC_COMB_ENTRIES * uECC_MAX_WORDS * 2];
+static uECC_Curve g_comb_curve = 0;
+#endif
+
+static const uECC_word_t *comb_table(uECC_Curve curve) {
+#if uECC_COMB_CONST_TABLE
+    return curve == uECC_secp192r1() ? comb_secp192r1 : 0;
+#else
+    return curve == g_comb_curve ? g_comb_table : 0;
+#endif
+}
+
+static bitcount_t comb_spacing(uECC_Curve curve) {
+    return (curve->num_n_bits + uECC_COMB_WIDTH - 1) / uECC_COMB_WIDTH;
+}
+
+/* (X1, Y1, Z1) += (x2, y2), Jacobian plus affine. Returns 0 if the points are equal or opposite,
+   (X1, Y1, Z1) is garbage then. Takes the same steps either way. */
+static uECC_word_t EccPoint_add_affine(uECC_word_t * X1,
+                                       uECC_word_t * Y1,
+                                       uECC_word_t * Z1,
+                                       const uECC_word_t * x2,
+                                       const uECC_word_t * y2,
+                                       uECC_Curve curve) {
+    uECC_word_t t1[uECC_MAX_WORDS];
+    uECC_word_t t2[uECC_MAX_WORDS];
+    uECC_word_t t3[uECC_MAX_WORDS];
+    uECC_word_t t4[uECC_MAX_WORDS];
+    uECC_word_t ok;
+    wordcount_t num_words = curve->num_words;
+
+    uECC_vli_modSquare_fast(t1, Z1, curve);              /* t1 = z1^2 */
+    uECC_vli_modMult_fast(t2, x2, t1, curve);            /* t2 = x2*z1^2 = U2 */
+    uECC_vli_modMult_fast(t1, t1, Z1, curve);            /* t1 = z1^3 */
+    uECC_vli_modMult_fast(t1, y2, t1, curve);            /* t1 = y2*z1^3 = S2 */
+    uECC_vli_modSub(t2, t2, X1, curve->p, num_words);    /* t2 = U2 - x1 = H */
+    uECC_vli_modSub(t1, t1, Y1, curve->p, num_words);    /* t1 = S2 - y1 = R */
+    ok = !uECC_vli_isZero(t2, num_words);
+
+    uECC_vli_modMult_fast(Z1, Z1, t2, curve);            /* z3 = z1*H */
+    uECC_vli_modSquare_fast(t3, t2, curve);              /* t3 = H^2 */
+    uECC_vli_modMult_fast(t4, t3, t2, curve);            /* t4 = H^3 */
+    uECC_vli_modMult_fast(t3, X1, t3, curve);            /* t3 = x1*H^2 = V */
+    uECC_vli_modSquare_fast(X1, t1, curve);              /* x3 = R^2 */
+    uECC_vli_modSub(X1, X1, t4, curve->p, num_words);    /* x3 = R^2 - H^3 */
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words);
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words);    /* x3 = R^2 - H^3 - 2V */
+    uECC_vli_modSub(t2, t3, X1, curve->p, num_words);    /* t2 = V - x3 */
+    uECC_vli_modMult_fast(t2, t2, t1, curve);            /* t2 = R*(V - x3) */
+    uECC_vli_modMult_fast(Y1, Y1, t4, curve);            /* t2 = y1*H^3 */
+    uECC_vli_modSub(Y1, t2, Y1, curve->p, num_words);    /* y3 = R*(V - x3) - y1*H^3 */
+    return ok;
+}
+
+/* dest = src if mask is all ones, unchanged if it is zero. */
+static void vli_select(uECC_word_t *dest,
+                       const uECC_word_t *src,
+                       uECC_word_t mask,
+                       wordcount_t num_words) {
+    wordcount_t i;
+    for (i = 0; i < num_words; ++i) {
+        dest[i] = (dest[i] & ~mask) | (src[i] & mask);
+    }
+}
+
+/* Computes scalar * G in Jacobian coordinates using the comb table. Returns 0 if there is no
+   table for this curve or an exceptional addition came up; the caller falls back to the ladder.
+   Nothing depends on the scalar but the values: every column takes one doubling and one addition,
+   a zero column adds a dummy point and throws the sum away by a masked select, and every table
+   entry is read on each step. Starting from Q instead of the point at infinity keeps leading
+   zero columns from showing, and makes an exceptional addition as unlikely as guessing k. */
+static uECC_word_t EccPoint_mult_comb_jacobian(uECC_word_t * X1,
+                                               uECC_word_t * Y1,
+                                               uECC_word_t * Z1,
+                                               const uECC_word_t * scalar,
+                                               uECC_Curve curve) {
+    const uECC_word_t *table = comb_table(curve);
+    uECC_word_t point[uECC_MAX_WORDS * 2];
+    uECC_word_t X2[uECC_MAX_WORDS];
+    uECC_word_t Y2[uECC_MAX_WORDS];
+    uECC_word_t Z2[uECC_MAX_WORDS];
+    uECC_word_t mask;
+    uECC_word_t used;
+    uECC_word_t ok = 1;
+    wordcount_t num_words = curve->num_words;
+    bitcount_t spacing = comb_spacing(curve);
+    bitcount_t column;
+    bitcount_t bit;
+    unsigned index;
+    unsigned i;
+
+    if (!table) {
+        return 0;
+    }
+
+    uECC_vli_set(X1, table + uECC_COMB_POINTS * num_words * 2, num_words);
+    uECC_vli_set(Y1, table + uECC_COMB_POINTS * num_words * 2 + num_words, num_words);
+    uECC_vli_clear(Z1, num_words);
+    Z1[0] = 1;
+
+    for (column = spacing - 1; column >= 0; --column) {
+        curve->double_jacobian(X1, Y1, Z1, curve);
+
+        index = 0;
+        for (i = 0; i < uECC_COMB_WIDTH; ++i) {
+            bit = i * spacing + column;
+            if (bit < curve->num_n_bits) {
+                index |= (unsigned)((scalar[bit >> uECC_WORD_BITS_SHIFT] >>
+                                     (bit & uECC_WORD_BITS_MASK)) & 1) << i;
+            }
+        }
+
+        uECC_vli_clear(point, num_words * 2);
+        for (i = 1; i <= uECC_COMB_POINTS; ++i) {
+            /* all ones when i == index, without a branch */
+            mask = (uECC_word_t)0 - (uECC_word_t)((((unsigned)(i ^ index)) - 1) >>
+                                                 (sizeof(unsigned) * 8 - 1));
+            vli_select(point, table + (i - 1) * num_words * 2, mask, num_words * 2);
+        }
+
+        /* all ones unless index is 0, then point is (0, 0) and the sum is thrown away */
+        used = (uECC_word_t)0 - (uECC_word_t)((0u - index) >> (sizeof(unsigned) * 8 - 1));
+        uECC_vli_set(X2, X1, num_words);
+        uECC_vli_set(Y2, Y1, num_words);
+        uECC_vli_set(Z2, Z1, num_words);
+        ok &= EccPoint_add_affine(X2, Y2, Z2, point, point + num_words, curve) | (~used & 1);
+        vli_select(X1, X2, used, num_words);
+        vli_select(Y1, Y2, used, num_words);
+        vli_select(Z1, Z2, used, num_words);
+    }
+
+    /* 2^spacing * Q + scalar * G - 2^spacing * Q */
+    ok &= EccPoint_add_affine(X1, Y1, Z1, table + (uECC_COMB_POINTS + 1) * num_words * 2,
+                              table + (uECC_COMB_POINTS + 1) * num_words * 2 + num_words, curve);
+    return ok;
+}
+
+/* result = scalar * G using the comb table. Returns 0 if the caller has to use the ladder. */
+static uECC_word_t EccPoint_mult_comb(uECC_word_t * result,
+                                      const uECC_word_t * scalar,
+                                      uECC_Curve curve) {
+    uECC_word_t z[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+
+    if (!EccPoint_mult_comb_jacobian(result, result + num_words, z, scalar, curve)) {
+        return 0;
+    }
+    uECC_vli_modInv(z, z, curve->p, num_words);
+    apply_z(result, result + num_words, z, curve);
+    return 1;
+}
+
+int uECC_precompute_comb(uECC_Curve curve) {
+#if uECC_COMB_CONST_TABLE
+    return comb_table(curve) != 0;
+#else
+    uECC_word_t X[uECC_MAX_WORDS];
+    uECC_word_t Y[uECC_MAX_WORDS];
+    uECC_word_t Z[uECC_MAX_WORDS];
+    uECC_word_t *entry;
+    const uECC_word_t *base;
+    wordcount_t num_words = curve->num_words;
+    bitcount_t spacing = comb_spacing(curve);
+    bitcount_t b;
+    unsigned i;
+    unsigned j;
+
+    g_comb_curve = 0;
+
+    /* Entry 2^i - 1 = 2^(i * spacing) * G. */
+    uECC_vli_set(X, curve->G, num_words);
+    uECC_vli_set(Y, curve->G + num_words, num_words);
+    uECC_vli_clear(Z, num_words);
+    Z[0] = 1;
+    for (i = 0; i < uECC_COMB_WIDTH; ++i) {
+        if (i > 0) {
+            for (b = 0; b < spacing; ++b) {
+                curve->double_jacobian(X, Y, Z, curve);
+            }
+        }
+        entry = g_comb_table + ((1u << i) - 1) * num_words * 2;
+        uECC_vli_set(entry, X, num_words);
+        uECC_vli_set(entry + num_words, Y, num_words);
+        uECC_vli_modInv(Z, Z, curve->p, num_words);
+        apply_z(entry, entry + num_words, Z, curve);
+        uECC_vli_set(X, entry, num_words);
+        uECC_vli_set(Y, entry + num_words, num_words);
+        uECC_vli_clear(Z, num_words);
+        Z[0] = 1;
+    }
+
+    /* Q carries on doubling from the last row, then 2^spacing * Q is negated. */
+    for (i = 0; i < 2; ++i) {
+        for (b = 0; b < spacing; ++b) {
+            curve->double_jacobian(X, Y, Z, curve);
+        }
+        entry = g_comb_table + (uECC_COMB_POINTS + i) * num_words * 2;
+        uECC_vli_set(entry, X, num_words);
+        uECC_vli_set(entry + num_words, Y, num_words);
+        uECC_vli_modInv(Z, Z, curve->p, num_words);
+        apply_z(entry, entry + num_words, Z, curve);
+        uECC_vli_set(X, entry, num_words);
+        uECC_vli_set(Y, entry + num_words, num_words);
+        uECC_vli_clear(Z, num_words);
+        Z[0] = 1;
+    }
+    entry = g_comb_table + (uECC_COMB_POINTS + 1) * num_words * 2;
+    uECC_vli_sub(entry + num_words, curve->p, entry + num_words, num_words);
+
+    /* Every other entry j = (highest bit of j) + (the rest of j), both already in the table. */
+    for (j = 3; j <= uECC_COMB_POINTS; ++j) {
+        unsigned high = j;
+        while (high & (high - 1)) {
+            high &= high - 1;
+        }
+        if (j == high) {
+            continue;
+        }
+        base = g_comb_table + (j - high - 1) * num_words * 2;
+        entry = g_comb_table + (high - 1) * num_words * 2;
+        uECC_vli_set(X, base, num_words);
+        uECC_vli_set(Y, base + num_words, num_words);
+        uECC_vli_clear(Z, num_words);
+        Z[0] = 1;
+        if (!EccPoint_add_affine(X, Y, Z, entry, entry + num_words, curve)) {
+            return 0;
+        }
+        entry = g_comb_table + (j - 1) * num_words * 2;
+        uECC_vli_modInv(Z, Z, curve->p, num_words);
+        apply_z(X, Y, Z, curve);
+        uECC_vli_set(entry, X, num_words);
+        uECC_vli_set(entry + num_words, Y, num_words);
+    }
+
+    g_comb_curve = curve;
+    return 1;
+#endif /* uECC_COMB_CONST_TABLE */
+}
+
+#endif /* uECC_SUPPORT_FIXED_BASE_COMB */
+
 static uECC_word_t regularize_k(const uECC_word_t * const k,
                                 uECC_word_t *k0,
                                 uECC_word_t *k1,
@@ -920,6 +1238,12 @@ static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
     uECC_word_t *p2[2] = {tmp1, tmp2};
     uECC_word_t carry;
 
+#if uECC_SUPPORT_FIXED_BASE_COMB
+    if (EccPoint_mult_comb(result, private, curve)) {
+        return 1;
+    }
+#endif
+
     /* Regularize the bitcount for the private key so that attackers cannot use a side channel
        attack to learn the number of leading zeros. */
     carry = regularize_k(private, tmp1, tmp2, curve);
@@ -1188,6 +1512,106 @@ int uECC_compute_public_key(const uint8_t *private_key, uint8_t *public_key, uEC
     return 1;
 }
 
+#if uECC_SUPPORT_BATCH_KEYGEN
+
+/* Montgomery's trick: replaces every ladders[i].z with its inverse using a single modInv and
+   3 * (count - 1) multiplications. All z values must be non-zero. */
+static void batch_modInv(EccPoint_ladder *ladders,
+                         uECC_word_t (*prefix)[uECC_MAX_WORDS],
+                         unsigned count,
+                         uECC_Curve curve) {
+    uECC_word_t inv[uECC_MAX_WORDS];
+    uECC_word_t tmp[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    unsigned i;
+
+    /* prefix[i] = z0 * z1 * ... * zi */
+    uECC_vli_set(prefix[0], ladders[0].z, num_words);
+    for (i = 1; i < count; ++i) {
+        uECC_vli_modMult_fast(prefix[i], prefix[i - 1], ladders[i].z, curve);
+    }
+    uECC_vli_modInv(inv, prefix[count - 1], curve->p, num_words);
+    /* inv = 1 / (z0 * ... * zi) on entry to each step */
+    for (i = count - 1; i > 0; --i) {
+        uECC_vli_modMult_fast(tmp, inv, prefix[i - 1], curve);    /* 1 / zi */
+        uECC_vli_modMult_fast(inv, inv, ladders[i].z, curve);     /* 1 / (z0 * ... * zi-1) */
+        uECC_vli_set(ladders[i].z, tmp, num_words);
+    }
+    uECC_vli_set(ladders[0].z, inv, num_words);
+}
+
+int uECC_make_keys_batch(unsigned count,
+                         uint8_t *public_keys,
+                         uint8_t *private_keys,
+                         uECC_Curve curve) {
+    EccPoint_ladder ladders[uECC_BATCH_SIZE];
+    uECC_word_t prefix[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t private[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t public[uECC_MAX_WORDS * 2];
+    uECC_word_t tmp1[uECC_MAX_WORDS];
+    uECC_word_t tmp2[uECC_MAX_WORDS];
+    uECC_word_t *p2[2] = {tmp1, tmp2};
+    uECC_word_t carry;
+    uECC_word_t tries;
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    wordcount_t num_bytes = curve->num_bytes;
+    wordcount_t num_n_bytes = BITS_TO_BYTES(curve->num_n_bits);
+    unsigned i;
+
+    while (count > 0) {
+        unsigned n = count < uECC_BATCH_SIZE ? count : uECC_BATCH_SIZE;
+        for (i = 0; i < n; ++i) {
+            for (tries = 0; tries < uECC_RNG_MAX_TRIES; ++tries) {
+                if (!uECC_generate_random_int(private[i], curve->n, num_n_words)) {
+                    return 0;
+                }
+                ladders[i].comb = 0;
+#if uECC_SUPPORT_FIXED_BASE_COMB
+                ladders[i].comb = EccPoint_mult_comb_jacobian(ladders[i].Rx[0], ladders[i].Ry[0],
+                                                              ladders[i].z, private[i], curve);
+#endif
+                if (!ladders[i].comb) {
+                    /* Same regularization as EccPoint_compute_public_key(). */
+                    carry = regularize_k(private[i], tmp1, tmp2, curve);
+                    EccPoint_mult_ladder(&ladders[i], curve->G, p2[!carry], 0, curve->num_n_bits + 1, curve);
+                }
+                /* A zero here means the point at infinity, it would also poison the whole batch. */
+                if (!uECC_vli_isZero(ladders[i].z, num_words)) {
+                    break;
+                }
+            }
+            if (tries == uECC_RNG_MAX_TRIES) {
+                return 0;
+            }
+        }
+
+        batch_modInv(ladders, prefix, n, curve);
+
+        for (i = 0; i < n; ++i) {
+            EccPoint_mult_finish(public, &ladders[i], curve->G, curve);
+            if (!uECC_valid_point(public, curve)) {
+                return 0;
+            }
+#if uECC_VLI_NATIVE_LITTLE_ENDIAN
+            bcopy(private_keys, (uint8_t *) private[i], num_n_bytes);
+            bcopy(public_keys, (uint8_t *) public, num_bytes);
+            bcopy(public_keys + num_bytes, (uint8_t *) (public + num_words), num_bytes);
+#else
+            uECC_vli_nativeToBytes(private_keys, num_n_bytes, private[i]);
+            uECC_vli_nativeToBytes(public_keys, num_bytes, public);
+            uECC_vli_nativeToBytes(public_keys + num_bytes, num_bytes, public + num_words);
+#endif
+            private_keys += num_n_bytes;
+            public_keys += num_bytes * 2;
+        }
+        count -= n;
+    }
+    return 1;
+}
+
+#endif /* uECC_SUPPORT_BATCH_KEYGEN */
+
 
 /* -------- ECDSA code -------- */
 
@@ -1238,24 +1662,20 @@ static int uECC_sign_with_k(const uint8_t *private_key,
 
     uECC_word_t tmp[uECC_MAX_WORDS];
     uECC_word_t s[uECC_MAX_WORDS];
-    uECC_word_t *k2[2] = {tmp, s};
 #if uECC_VLI_NATIVE_LITTLE_ENDIAN
     uECC_word_t *p = (uECC_word_t *)signature;
 #else
     uECC_word_t p[uECC_MAX_WORDS * 2];
 #endif
-    uECC_word_t carry;
     wordcount_t num_words = curve->num_words;
     wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
-    bitcount_t num_n_bits = curve->num_n_bits;
 
     /* Make sure 0 < k < curve_n */
     if (uECC_vli_isZero(k, num_words) || uECC_vli_cmp(curve->n, k, num_n_words) != 1) {
         return 0;
     }
 
-    carry = regularize_k(k, tmp, s, curve);
-    EccPoint_mult(p, curve->G, k2[!carry], 0, num_n_bits + 1, curve);
+    EccPoint_compute_public_key(p, k, curve); /* p = k * G, through the comb if there is one */
     if (uECC_vli_isZero(p, num_words)) {
         return 0;
     }
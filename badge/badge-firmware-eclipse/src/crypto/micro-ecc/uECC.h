@@ -72,6 +72,38 @@ to be word aligned on architectures that do not support unaligned accesses. */
     #define uECC_SUPPORT_COMPRESSED_POINT 1
 #endif
 
+/* uECC_SUPPORT_BATCH_KEYGEN - If enabled (defined as nonzero), uECC_make_keys_batch() is
+available. It needs roughly uECC_BATCH_SIZE * 7 * (curve size) bytes of stack, so it is meant for
+host tools rather than small targets. */
+#ifndef uECC_SUPPORT_BATCH_KEYGEN
+    #define uECC_SUPPORT_BATCH_KEYGEN 0
+#endif
+
+/* Number of keys uECC_make_keys_batch() shares one modular inversion between. */
+#ifndef uECC_BATCH_SIZE
+    #define uECC_BATCH_SIZE 32
+#endif
+
+/* uECC_SUPPORT_FIXED_BASE_COMB - If enabled (defined as nonzero), k * G for key generation,
+uECC_compute_public_key() and signing uses a comb table of multiples of G instead of the generic
+ladder, once a table exists for the curve (see uECC_precompute_comb()). The table takes
+(2^uECC_COMB_WIDTH + 1) * 2 * (curve size) bytes and the comb needs about 1 / uECC_COMB_WIDTH as
+many point operations as the ladder. Like the ladder it does the same work for every scalar. */
+#ifndef uECC_SUPPORT_FIXED_BASE_COMB
+    #define uECC_SUPPORT_FIXED_BASE_COMB 1
+#endif
+
+#ifndef uECC_COMB_WIDTH
+    #define uECC_COMB_WIDTH 5
+#endif
+
+/* uECC_COMB_CONST_TABLE - If enabled (defined as nonzero), use the const secp192r1 table from
+comb-secp192r1.inc, which ends up in flash, instead of building one in RAM with
+uECC_precompute_comb(). Regenerate it with scripts/comb_table.py if uECC_COMB_WIDTH changes. */
+#ifndef uECC_COMB_CONST_TABLE
+    #define uECC_COMB_CONST_TABLE 1
+#endif
+
 struct uECC_Curve_t;
 typedef const struct uECC_Curve_t * uECC_Curve;
 
@@ -162,6 +194,38 @@ Returns 1 if the key pair was generated successfully, 0 if an error occurred.
 */
 int uECC_make_key(uint8_t *public_key, uint8_t *private_key, uECC_Curve curve);
 
+#if uECC_SUPPORT_FIXED_BASE_COMB
+/* uECC_precompute_comb() function.
+Build the fixed-base comb table for the given curve. Until this is called, k * G uses the ladder.
+Only one curve has a table at a time. Call it once at startup, before any other thread uses uECC.
+With uECC_COMB_CONST_TABLE there is nothing to build.
+
+Returns 1 if the curve now has a comb table, 0 otherwise.
+*/
+int uECC_precompute_comb(uECC_Curve curve);
+#endif /* uECC_SUPPORT_FIXED_BASE_COMB */
+
+#if uECC_SUPPORT_BATCH_KEYGEN
+/* uECC_make_keys_batch() function.
+Create 'count' public/private key pairs. Same result as calling uECC_make_key() 'count' times,
+but the conversion of the public keys back to affine coordinates is done for up to
+uECC_BATCH_SIZE keys at once with a single modular inversion (Montgomery's trick), and every
+public key is checked to be on the curve.
+
+Outputs:
+    public_keys  - Will be filled in with 'count' public keys, one after the other. Must be at
+                   least count * 2 * the curve size (in bytes) long.
+    private_keys - Will be filled in with 'count' private keys, one after the other. Must be at
+                   least count * the curve order size (in bytes) long.
+
+Returns 1 if all key pairs were generated successfully, 0 if an error occurred.
+*/
+int uECC_make_keys_batch(unsigned count,
+                         uint8_t *public_keys,
+                         uint8_t *private_keys,
+                         uECC_Curve curve);
+#endif /* uECC_SUPPORT_BATCH_KEYGEN */
+
 /* uECC_shared_secret() function.
 Compute a shared secret given your secret key and someone else's public key.
 Note: It is recommended that you hash the result of uECC_shared_secret() before using it for
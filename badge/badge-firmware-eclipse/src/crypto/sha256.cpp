@@ -1,4 +1,4 @@
-#include <stdio.h> 
+#include <string.h>
 #include "sha256.h"
 
 #define RotL(a,b) (((a) << (b)) | ((a) >> (32-(b))))
@@ -12,7 +12,8 @@
 #define SIG0(x) (RotR(x,7) ^ RotR(x,18) ^ ((x) >> 3))
 #define SIG1(x) (RotR(x,17) ^ RotR(x,19) ^ ((x) >> 10))
 
-uint32 k[64] = {
+//const so it stays in flash on the badge
+static const uint32 k[64] = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
 	0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
 	0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
@@ -23,7 +24,70 @@ uint32 k[64] = {
 	0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
 };
 
-void sha256_init(ShaOBJ *ctx){  
+//W(j) for j >= 16 only needs the 16 words before it, so keep a rolling window instead of all 64
+#define SCHEDULE(j) (w[(j)&15] += SIG1(w[((j)-2)&15]) + w[((j)-7)&15] + SIG0(w[((j)-15)&15]))
+
+//One round with the registers renamed instead of shifted along, 8 of these bring them back round
+#define ROUND(a,b,c,d,e,f,g,h,j,wj) \
+	t1 = h + EP1(e) + CH(e,f,g) + k[j] + (wj); \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c)
+
+#define ROUNDS_8(j,W) \
+	ROUND(a,b,c,d,e,f,g,h,(j),W((j))); \
+	ROUND(h,a,b,c,d,e,f,g,(j)+1,W((j)+1)); \
+	ROUND(g,h,a,b,c,d,e,f,(j)+2,W((j)+2)); \
+	ROUND(f,g,h,a,b,c,d,e,(j)+3,W((j)+3)); \
+	ROUND(e,f,g,h,a,b,c,d,(j)+4,W((j)+4)); \
+	ROUND(d,e,f,g,h,a,b,c,(j)+5,W((j)+5)); \
+	ROUND(c,d,e,f,g,h,a,b,(j)+6,W((j)+6)); \
+	ROUND(b,c,d,e,f,g,h,a,(j)+7,W((j)+7))
+
+#define MESSAGE(j) w[j]
+
+//Compress one 64 byte block, read straight from wherever it is
+static void sha256_block(uint32 state[8], const uchar *block){
+	uint32 a,b,c,d,e,f,g,h;
+	uint32 t1;
+	uint32 w[16];
+	uint32 j;
+
+	//W(j) = M(j)
+	for(j=0;j<16;++j){
+		w[j] = ((uint32)block[0] << 24) | ((uint32)block[1] << 16) | ((uint32)block[2] << 8) | block[3];
+		block+=4;
+	}
+
+	//Initialize Registers
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	//Main Loop, first 16 rounds use the message as is
+	for(j=0;j<16;j+=8){
+		ROUNDS_8(j,MESSAGE);
+	}
+	for(;j<64;j+=8){
+		ROUNDS_8(j,SCHEDULE);
+	}
+
+	//Update State
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void sha256_init(ShaOBJ *ctx){
 	ctx->state[0] = 0x6a09e667;
 	ctx->state[1] = 0xbb67ae85;
 	ctx->state[2] = 0x3c6ef372;
@@ -37,110 +101,65 @@ void sha256_init(ShaOBJ *ctx){
 }
 
 void sha256_update(ShaOBJ* ctx){
-	uint32 a,b,c,d,e,f,g,h;
-	uint32 t1,t2;
-	uint32 w[64];
-	uint32 i,j;
+	sha256_block(ctx->state, ctx->data);
+}
 
-	//W(j) = M(j)
-	j=0;
-	for(i=0;i<16;++i){
-		w[i] = (ctx->data[j] << 24) | (ctx->data[j+1] << 16) | (ctx->data[j+2] << 8) | ctx->data[j+3];
-		j+=4;
-	}
+void sha256_add(ShaOBJ* ctx, const unsigned char* msg, uint32 len){
+	ctx->bit_len += (uint_64)len * 8;
 
-	//Compute W For J = 16..63
-	for(;i<64;++i){
-		w[i] = SIG1(w[i-2]) + w[i-7] + SIG0(w[i-15]) + w[i-16];
+	//Top Up A Partially Filled Block First
+	if(ctx->data_len>0){
+		uint32 n = 64 - ctx->data_len;
+		if(n>len){
+			n = len;
+		}
+		memcpy(&ctx->data[ctx->data_len], msg, n);
+		ctx->data_len += n;
+		msg += n;
+		len -= n;
+		if(ctx->data_len<64){
+			return;
+		}
+		sha256_block(ctx->state, ctx->data);
+		ctx->data_len = 0;
 	}
 
-	//Initialize Registers
-	a = ctx->state[0];
-	b = ctx->state[1];
-	c = ctx->state[2];
-	d = ctx->state[3];
-	e = ctx->state[4];
-	f = ctx->state[5];
-	g = ctx->state[6];
-	h = ctx->state[7];
-
-	//Main Loop
-	for(j=0;j<64;j++){
-		//Compute t1 and t2
-		t1 = h + EP1(e) + CH(e,f,g) + k[j] + w[j];
-		t2 = EP0(a) + MAJ(a,b,c);
-
-		//Move Registers Along
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + t2;
+	//Whole Blocks Straight From The Caller's Buffer
+	while(len>=64){
+		sha256_block(ctx->state, msg);
+		msg += 64;
+		len -= 64;
 	}
 
-	//Update State
-	ctx->state[0] += a;
-	ctx->state[1] += b;
-	ctx->state[2] += c;
-	ctx->state[3] += d;
-	ctx->state[4] += e;
-	ctx->state[5] += f;
-	ctx->state[6] += g;
-	ctx->state[7] += h;
-
-}
-
-void sha256_add(ShaOBJ* ctx, const unsigned char* msg, uint32 len){
-	uint32 off = 0;
-	ctx->bit_len += len*8;
-	while(off<len){
-		ctx->data[ctx->data_len] = *(msg+off);
-		ctx->data_len ++;
-		off ++;
-		if(ctx->data_len==64){
-			sha256_update(ctx);
-			ctx->data_len = 0;
-		}
-	}
+	//Keep The Tail For Next Time
+	memcpy(&ctx->data[0], msg, len);
+	ctx->data_len = len;
 }
 
-void sha256_digest(ShaOBJ* ctx, unsigned char hash[]){
-	uchar out[128];
+void sha256_digest(ShaOBJ* ctx, unsigned char hash[SHA256_HASH_SIZE]){
+	uint32 used = ctx->data_len;
 
-	//Create Final Block
-	uint32 size = ctx->data_len + (64-(ctx->data_len%65)); //Size Of Last Block(s) 64 or 128
-
-	//Copy Current Data
-	for(uint32 i=0;i<ctx->data_len;i++){
-		out[i] = ctx->data[i];
-	}
+	//Set 1 Flag (BYTE = 128)
+	ctx->data[used++] = 0x80;
 
-	//Zero Out Buffer
-	for(uint32 i=ctx->data_len;i<size;i++){
-		out[i] = 0x00;
+	//The 8 Byte Length Only Fits Below 56 Bytes, Otherwise It Takes Another Block
+	if(used>56){
+		memset(&ctx->data[used], 0, 64-used);
+		sha256_block(ctx->state, ctx->data);
+		used = 0;
 	}
-
-	//Set 1 Flag (BYTE = 128)
-	out[ctx->data_len] = 0x80;
+	memset(&ctx->data[used], 0, 56-used);
 
 	//Write Final Bit Length
-	for(int i=0;i<8;i++){
-		out[size-i-1] = ctx->bit_len >> i*8;
+	for(int n=0;n<8;n++){
+		ctx->data[63-n] = ctx->bit_len >> n*8;
 	}
-
-	//Clear CTX Data Buffer (Move To The Start, It Will Override By It Self)
+	sha256_block(ctx->state, ctx->data);
 	ctx->data_len = 0;
 
-	//Update
-	sha256_add(ctx,(uchar*)&out,size);
-
 	//Transform From Little Endian To Big Endian
 	for(int n=0;n<8;n++){
 		for(int i=3;i>=0;i--){
-			//printf("%x - ",ctx->state[i]);
 			hash[n*4+(3-i)] = (ctx->state[n] >> i*8) & 0xFF;
 		}
 	}